@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+Statistics Determinism Check
+
+This test verifies that two gem5/NVMain runs of the same workload and
+configuration produced the same simulated results, i.e. that the
+simulation is deterministic:
+1. Both statistics files contain the same number of dumps
+2. Every simulated statistic exists in both runs
+3. Every simulated statistic has the same value
+
+Host statistics (host_seconds, hostSeconds, host_tick_rate, ...) are
+expected to differ and are ignored. A statistic that is nan in both runs
+matches.
+
+Usage:
+    python3 compare_stats.py <reference_stats> <test_stats> [--prefix P]
+                             [--tolerance T]
+"""
+
+import argparse
+import math
+import re
+import sys
+
+
+DUMP_BEGIN = re.compile(r'-+ Begin Simulation Statistics -+')
+
+
+def parse_stats(stats_file):
+    """Parse a gem5/NVMain statistics file into one dict per stats dump"""
+    dumps = []
+    current = None
+
+    with open(stats_file, 'r') as f:
+        for line in f:
+            line = line.strip()
+
+            if DUMP_BEGIN.match(line):
+                current = {}
+                dumps.append(current)
+                continue
+
+            # Parse stat lines: "stat_name    value    # comment"
+            match = re.match(r'(\S+)\s+(\S+)', line)
+            if not match or line.startswith('-'):
+                continue
+
+            # Files without dump markers are treated as a single dump
+            if current is None:
+                current = {}
+                dumps.append(current)
+
+            stat_name = match.group(1)
+            stat_value = match.group(2)
+            try:
+                current[stat_name] = float(stat_value)
+            except ValueError:
+                current[stat_name] = stat_value
+
+    return dumps
+
+
+def is_host_stat(name):
+    """Host statistics depend on the machine running the simulation"""
+    return name.split('.')[-1].lower().startswith('host')
+
+
+def values_match(ref, test, tolerance):
+    """Compare two statistic values with an optional relative tolerance"""
+    if isinstance(ref, float) and isinstance(test, float):
+        if ref == test or (math.isnan(ref) and math.isnan(test)):
+            return True
+        if not (math.isfinite(ref) and math.isfinite(test)):
+            return False
+        return abs(ref - test) <= tolerance * max(abs(ref), abs(test))
+    return ref == test
+
+
+def compare_dump(index, ref, test, prefix, tolerance):
+    """Compare a single stats dump, returns the number of mismatches"""
+    names = sorted(name for name in set(ref) | set(test)
+                   if name.startswith(prefix) and not is_host_stat(name))
+
+    mismatches = 0
+    for name in names:
+        if name not in ref or name not in test:
+            where = 'reference' if name not in ref else 'test'
+            print(f"  ✗ Dump {index}: {name} missing in {where} run")
+            mismatches += 1
+        elif not values_match(ref[name], test[name], tolerance):
+            print(f"  ✗ Dump {index}: {name} = {ref[name]} (reference) "
+                  f"vs {test[name]} (test)")
+            mismatches += 1
+
+    print(f"  Dump {index}: compared {len(names)} statistics, "
+          f"{mismatches} mismatches")
+    return mismatches
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the simulated statistics of two gem5/NVMain runs"
+    )
+
+    parser.add_argument('reference', help='Reference stats.txt')
+    parser.add_argument('test', help='stats.txt of the run under test')
+
+    parser.add_argument('--prefix', type=str, default='',
+                        help='Only compare statistics starting with this '
+                             'prefix (e.g. system.mem_ctrl)')
+
+    parser.add_argument('--tolerance', type=float, default=0.0,
+                        help='Relative tolerance for numeric statistics '
+                             '(default: exact match)')
+
+    args = parser.parse_args()
+
+    print("=" * 50)
+    print("Statistics Determinism Check")
+    print("=" * 50)
+    print(f"Reference: {args.reference}")
+    print(f"Test:      {args.test}")
+    print()
+
+    try:
+        ref_dumps = parse_stats(args.reference)
+        test_dumps = parse_stats(args.test)
+    except FileNotFoundError as e:
+        print(f"ERROR: Statistics file not found: {e.filename}")
+        sys.exit(1)
+
+    if len(ref_dumps) != len(test_dumps):
+        print(f"  ✗ FAILED: {len(ref_dumps)} dumps in reference, "
+              f"{len(test_dumps)} dumps in test run")
+        sys.exit(1)
+
+    if not ref_dumps:
+        print("  ✗ FAILED: No statistics found")
+        sys.exit(1)
+
+    mismatches = 0
+    for index, (ref, test) in enumerate(zip(ref_dumps, test_dumps)):
+        mismatches += compare_dump(index, ref, test, args.prefix,
+                                   args.tolerance)
+
+    print()
+    if mismatches == 0:
+        print("ALL STATISTICS MATCH ✓✓✓")
+        sys.exit(0)
+
+    print(f"{mismatches} STATISTICS DIFFER ✗")
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -7,6 +7,17 @@ the Dynamic ReRAM Region Mapping implementation with NVMain.
 
 Usage:
     gem5.fast tests/nvmain_test_config.py [options]
+
+Region of interest (--roi, SE mode only):
+    This configuration runs syscall-emulation (SE) processes, and --roi is
+    only supported there; there is no full-system (FS) ROI support. The
+    workload marks its region of interest with the gem5 m5ops
+    m5_work_begin() / m5_work_end() (libm5, include/gem5/m5ops.h). Outside
+    the ROI the system runs on AtomicSimpleCPU, so NVMain only sees
+    functional (atomic) accesses and no region scores, epochs or stats are
+    accumulated. At work begin the statistics are reset and the detailed
+    --cpu-type takes over; at work end the statistics are dumped and the
+    system falls back to the atomic CPU until the next ROI or exit.
 """
 
 import argparse
@@ -25,6 +36,64 @@ from m5.util import addToPath
 addToPath('../configs/common')
 addToPath('../configs')
 
+def create_cpu(cpu_type, switched_out=False):
+    """Create a CPU of the given type"""
+
+    if cpu_type == "AtomicSimpleCPU":
+        return AtomicSimpleCPU(switched_out=switched_out)
+    elif cpu_type == "TimingSimpleCPU":
+        return TimingSimpleCPU(switched_out=switched_out)
+
+    print(f"Error: Unsupported CPU type {cpu_type}")
+    sys.exit(1)
+
+
+def create_roi_cpus(system, args):
+    """Create the switched-out detailed CPUs that run the region of interest"""
+
+    roi_cpus = []
+    for cpu in system.cpu:
+        roi_cpu = create_cpu(args.cpu_type, switched_out=True)
+        roi_cpu.cpu_id = cpu.cpu_id
+        roi_cpu.system = system
+        roi_cpu.workload = cpu.workload
+        roi_cpu.clk_domain = cpu.clk_domain
+        roi_cpu.isa = cpu.isa
+        roi_cpu.createThreads()
+        roi_cpus.append(roi_cpu)
+
+    return roi_cpus
+
+
+def simulate_roi(system):
+    """Run the workload, switching CPUs at the ROI markers
+
+    Returns the exit event that ended the simulation.
+    """
+
+    in_roi = False
+
+    while True:
+        exit_event = m5.simulate()
+        cause = exit_event.getCause()
+
+        if cause == "workbegin" and not in_roi:
+            print(f"ROI begin at tick {m5.curTick()}")
+            m5.switchCpus(system, list(zip(system.cpu, system.roi_cpu)))
+            m5.stats.reset()
+            in_roi = True
+        elif cause == "workend" and in_roi:
+            print(f"ROI end at tick {m5.curTick()}")
+            m5.stats.dump()
+            m5.switchCpus(system, list(zip(system.roi_cpu, system.cpu)))
+            in_roi = False
+        elif cause in ("workbegin", "workend"):
+            # Unbalanced marker, keep running in the current mode
+            print(f"Warning: ignoring {cause} at tick {m5.curTick()}")
+        else:
+            return exit_event
+
+
 def create_simple_system(args):
     """Create a minimal system for NVMain testing"""
 
@@ -36,17 +105,24 @@ def create_simple_system(args):
     system.clk_domain.clock = '2.4GHz'
     system.clk_domain.voltage_domain = VoltageDomain()
 
-    # Create CPU
-    if args.cpu_type == "AtomicSimpleCPU":
-        system.cpu = AtomicSimpleCPU()
-    elif args.cpu_type == "TimingSimpleCPU":
-        system.cpu = TimingSimpleCPU()
-    else:
-        print(f"Error: Unsupported CPU type {args.cpu_type}")
-        sys.exit(1)
+    # Create CPUs
+    # With --roi the atomic CPU runs everything outside the region of
+    # interest and the requested CPU type is only switched in for the ROI.
+    cpu_type = "AtomicSimpleCPU" if args.roi else args.cpu_type
+    # Each core issues its requests under its own gem5 requestor
+    # (system.cpuN.inst / system.cpuN.data), which NVMain uses to attribute
+    # traffic to cores.
+    system.cpu = [create_cpu(cpu_type) for _ in range(args.num_cpus)]
+    for cpu_id, cpu in enumerate(system.cpu):
+        cpu.cpu_id = cpu_id
 
     # Set up memory mode
-    system.mem_mode = 'timing' if args.cpu_type == "TimingSimpleCPU" else 'atomic'
+    system.mem_mode = 'timing' if cpu_type == "TimingSimpleCPU" else 'atomic'
+
+    # m5_work_begin()/m5_work_end() exit the simulation loop so that
+    # main() can switch CPUs and reset/dump the statistics
+    if args.roi:
+        system.exit_on_work_items = True
 
     # Memory ranges
     system.mem_ranges = [AddrRange('4GB')]
@@ -54,32 +130,35 @@ def create_simple_system(args):
     # Create memory bus
     system.membus = SystemXBar()
 
-    # Set up caches if requested
-    if args.caches:
-        system.cpu.icache = Cache(size='32kB', assoc=2)
-        system.cpu.dcache = Cache(size='8kB', assoc=2)
+    # Shared L2 cache if requested, the L1 caches of all cores sit on l2bus
+    if args.l2cache:
+        system.l2cache = Cache(size='8kB', assoc=4)
+        system.l2bus = L2XBar()
 
-        system.cpu.icache.cpu_side = system.cpu.icache_port
-        system.cpu.dcache.cpu_side = system.cpu.dcache_port
+        system.l2cache.cpu_side = system.l2bus.mem_side_ports
+        system.l2cache.mem_side = system.membus.cpu_side_ports
+        l1_mem_side = system.l2bus.cpu_side_ports
+    else:
+        l1_mem_side = system.membus.cpu_side_ports
 
-        if args.l2cache:
-            system.l2cache = Cache(size='8kB', assoc=4)
-            system.l2bus = L2XBar()
+    for cpu in system.cpu:
+        # Set up private L1 caches if requested
+        if args.caches:
+            cpu.icache = Cache(size='32kB', assoc=2)
+            cpu.dcache = Cache(size='8kB', assoc=2)
 
-            system.cpu.icache.mem_side = system.l2bus.cpu_side_ports
-            system.cpu.dcache.mem_side = system.l2bus.cpu_side_ports
-            system.l2cache.cpu_side = system.l2bus.mem_side_ports
-            system.l2cache.mem_side = system.membus.cpu_side_ports
+            cpu.icache.cpu_side = cpu.icache_port
+            cpu.dcache.cpu_side = cpu.dcache_port
+
+            cpu.icache.mem_side = l1_mem_side
+            cpu.dcache.mem_side = l1_mem_side
         else:
-            system.cpu.icache.mem_side = system.membus.cpu_side_ports
-            system.cpu.dcache.mem_side = system.membus.cpu_side_ports
-    else:
-        # No caches - direct connection
-        system.cpu.icache_port = system.membus.cpu_side_ports
-        system.cpu.dcache_port = system.membus.cpu_side_ports
+            # No caches - direct connection
+            cpu.icache_port = system.membus.cpu_side_ports
+            cpu.dcache_port = system.membus.cpu_side_ports
 
-    # Create interrupt controller (required for ARM)
-    system.cpu.createInterruptController()
+        # Create interrupt controller (required for ARM)
+        cpu.createInterruptController()
 
     # Set up memory
     if args.mem_type == "NVMainMemory":
@@ -104,18 +183,36 @@ def create_simple_system(args):
     return system
 
 
-def create_process(args):
-    """Create a simple process to run"""
+def create_processes(args):
+    """Create one simple process per core
 
-    process = Process()
+    --cmd takes a ';' separated list of commands, one per core, and
+    --options the matching ';' separated argument strings. A single command
+    or argument string is used on every core, as independent processes.
+    Each command is one argv entry, so its path may contain spaces.
+    """
 
-    if args.cmd:
-        process.cmd = [args.cmd]
-    else:
-        # Default: just exit immediately
-        process.cmd = ['/bin/true']
+    def per_core(values, option):
+        if len(values) == 1:
+            return values * args.num_cpus
+        if len(values) != args.num_cpus:
+            print(f"Error: {option} has {len(values)} entries for "
+                  f"{args.num_cpus} CPUs")
+            sys.exit(1)
+        return values
+
+    # Default: just exit immediately
+    cmds = per_core(args.cmd.split(';') if args.cmd else ['/bin/true'], '--cmd')
+    options = per_core(args.options.split(';') if args.options else [''],
+                       '--options')
+
+    processes = []
+    for cpu_id, (cmd, opts) in enumerate(zip(cmds, options)):
+        process = Process(pid=100 + cpu_id)
+        process.cmd = [cmd] + opts.split()
+        processes.append(process)
 
-    return process
+    return processes
 
 
 def main():
@@ -133,6 +230,9 @@ def main():
     parser.add_argument('--nvmain-config', type=str, default=None,
                         help='Path to NVMain configuration file')
 
+    parser.add_argument('--num-cpus', type=int, default=1,
+                        help='Number of cores (private L1s, shared L2)')
+
     parser.add_argument('--caches', action='store_true',
                         help='Enable L1 caches')
 
@@ -140,7 +240,19 @@ def main():
                         help='Enable L2 cache (requires --caches)')
 
     parser.add_argument('--cmd', type=str, default=None,
-                        help='Command to run (default: /bin/true)')
+                        help='Command to run, or one per core separated '
+                             'by \';\' (default: /bin/true). A single '
+                             'command runs on every core; any other count '
+                             'must equal --num-cpus')
+
+    parser.add_argument('--options', type=str, default=None,
+                        help='Arguments of the command, \';\' separated '
+                             'per core like --cmd')
+
+    parser.add_argument('--roi', action='store_true',
+                        help='Only simulate in detail between the m5ops '
+                             'work begin/end markers of the workload '
+                             '(SE mode only)')
 
     args = parser.parse_args()
 
@@ -149,10 +261,19 @@ def main():
         print("Error: --l2cache requires --caches")
         sys.exit(1)
 
+    if args.num_cpus < 1:
+        print("Error: --num-cpus must be at least 1")
+        sys.exit(1)
+
+    if args.roi and args.cpu_type == "AtomicSimpleCPU":
+        print("Error: --roi requires a detailed CPU type (e.g. TimingSimpleCPU)")
+        sys.exit(1)
+
     print("=" * 60)
     print("gem5 NVMain Test Configuration")
     print("=" * 60)
     print(f"CPU Type: {args.cpu_type}")
+    print(f"CPUs: {args.num_cpus}")
     print(f"Memory Type: {args.mem_type}")
     if args.nvmain_config:
         print(f"NVMain Config: {args.nvmain_config}")
@@ -160,23 +281,33 @@ def main():
     if args.caches:
         print(f"L2 Cache: {'Yes' if args.l2cache else 'No'}")
     print(f"Command: {args.cmd if args.cmd else '/bin/true'}")
+    if args.options:
+        print(f"Options: {args.options}")
+    print(f"ROI Only: {'Yes' if args.roi else 'No'}")
     print("=" * 60)
     print()
 
     # Create system
     system = create_simple_system(args)
 
-    # Create process and assign to CPU
-    process = create_process(args)
-    system.cpu.workload = process
-    system.cpu.createThreads()
+    # Create processes and assign one to each CPU
+    processes = create_processes(args)
+    for cpu, process in zip(system.cpu, processes):
+        cpu.workload = process
+        cpu.createThreads()
+
+    if args.roi:
+        system.roi_cpu = create_roi_cpus(system, args)
 
     # Instantiate system
     root = Root(full_system=False, system=system)
     m5.instantiate()
 
     print("Beginning simulation...")
-    exit_event = m5.simulate()
+    if args.roi:
+        exit_event = simulate_roi(system)
+    else:
+        exit_event = m5.simulate()
 
     print()
     print("=" * 60)
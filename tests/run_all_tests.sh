@@ -3,10 +3,13 @@
 # Comprehensive Test Suite for Dynamic ReRAM Region Mapping
 #
 # This script runs all tests to verify the implementation:
-# 1. Unit tests for address translation
-# 2. Component loading verification
-# 3. Migration algorithm validation
-# 4. Performance comparison with baseline
+# 1. Unit tests for address translation and migration policies
+# 2. Analysis tools build, and the analytical estimator matching the online
+#    replay of the oracle placement analyzer
+# 3. Component loading verification
+# 4. Migration algorithm validation
+# 5. Performance comparison with baseline
+# 6. Determinism: a repeated run of the same workload reproduces its statistics
 
 set -e
 
@@ -75,6 +78,12 @@ run_test() {
 compile_unit_tests() {
     echo "Compiling unit tests..."
     g++ -std=c++11 -o tests/test_address_translation tests/test_address_translation.cpp
+    g++ -std=c++11 -O2 -o tests/test_tenant_quota tests/test_tenant_quota.cpp
+    g++ -std=c++11 -O2 -o tests/test_migration_policy tests/test_migration_policy.cpp
+    g++ -std=c++11 -O2 -pthread -o tests/test_trace_format tests/test_trace_format.cpp
+    g++ -std=c++11 -O2 -pthread -o tests/test_trace_reader tests/test_trace_reader.cpp
+    g++ -std=c++11 -O2 -pthread -o tests/test_replay_engine tests/test_replay_engine.cpp
+    g++ -std=c++11 -O2 -o tests/test_line_compression tests/test_line_compression.cpp
     print_success "Unit tests compiled"
 }
 
@@ -87,12 +96,45 @@ run_test "Compile Unit Tests" "compile_unit_tests"
 run_unit_tests() {
     echo "Running unit tests..."
     tests/test_address_translation
+    tests/test_tenant_quota
+    tests/test_migration_policy
+    tests/test_trace_format
+    tests/test_trace_reader
+    tests/test_replay_engine
+    tests/test_line_compression
 }
 
 run_test "Address Translation Unit Tests" "run_unit_tests"
 
 # ========================================
-# Test 3: Component Loading
+# Test 3: Compile Analysis Tools
+# ========================================
+
+compile_tools() {
+    echo "Compiling analysis tools..."
+    g++ -std=c++11 -O2 -pthread -o tools/oracle_placement tools/oracle_placement.cpp
+    g++ -std=c++11 -O2 -pthread -o tools/analytical_estimator tools/analytical_estimator.cpp
+    g++ -std=c++11 -O2 -pthread -o tools/trace_convert tools/trace_convert.cpp
+    g++ -std=c++11 -O2 -pthread -o tools/trace_replay tools/trace_replay.cpp
+    print_success "Analysis tools compiled"
+}
+
+run_test "Compile Analysis Tools" "compile_tools"
+
+# ========================================
+# Test 4: Estimator Cross-Check
+# ========================================
+
+run_estimator_check() {
+    echo "Comparing analytical_estimator with oracle_placement..."
+    python3 tests/test_estimator_oracle.py --estimator tools/analytical_estimator \
+        --oracle tools/oracle_placement
+}
+
+run_test "Estimator Cross-Check" "run_estimator_check"
+
+# ========================================
+# Test 5: Component Loading
 # ========================================
 
 run_component_test() {
@@ -112,9 +154,20 @@ else
 fi
 
 # ========================================
-# Test 4: Simple Memory Test
+# Test 6: Simple Memory Test
 # ========================================
 
+run_simple_workload() {
+    simulator/gem5/build/ARM/gem5.fast \
+        --outdir="$1" \
+        tests/nvmain_test_config.py \
+        --mem-type=NVMainMemory \
+        --nvmain-config=simulator/nvmain/Config/ReRAM_DynamicMapping.config \
+        --cpu-type=TimingSimpleCPU \
+        --caches --l2cache \
+        --cmd=tests/simple_mem_test
+}
+
 run_simple_memory_test() {
     print_header "Simple Memory Access Test"
 
@@ -163,14 +216,7 @@ EOF
 
     # Run with gem5 (using non-deprecated config)
     echo "Running with gem5/NVMain..."
-    simulator/gem5/build/ARM/gem5.fast \
-        --outdir=m5out/simple_test \
-        tests/nvmain_test_config.py \
-        --mem-type=NVMainMemory \
-        --nvmain-config=simulator/nvmain/Config/ReRAM_DynamicMapping.config \
-        --cpu-type=TimingSimpleCPU \
-        --caches --l2cache \
-        --cmd=tests/simple_mem_test
+    run_simple_workload m5out/simple_test
 
     print_success "Simple memory test completed"
     echo "Output in: m5out/simple_test/"
@@ -183,7 +229,7 @@ else
 fi
 
 # ========================================
-# Test 5: Migration Algorithm Validation
+# Test 7: Migration Algorithm Validation
 # ========================================
 
 run_migration_validation() {
@@ -206,7 +252,28 @@ else
 fi
 
 # ========================================
-# Test 6: Configuration Validation
+# Test 8: Determinism Check
+# ========================================
+
+run_determinism_check() {
+    print_header "Determinism Check"
+
+    # A second run of the same workload must reproduce every simulated
+    # statistic of the first
+    echo "Repeating the simple memory test..."
+    run_simple_workload m5out/simple_test_repeat
+    python3 tests/compare_stats.py m5out/simple_test/stats.txt \
+        m5out/simple_test_repeat/stats.txt
+}
+
+if [ -f "simulator/gem5/build/ARM/gem5.fast" ] && [ -f "m5out/simple_test/stats.txt" ]; then
+    run_test "Determinism Check" "run_determinism_check"
+else
+    print_warning "Skipping determinism check (no statistics available)"
+fi
+
+# ========================================
+# Test 9: Configuration Validation
 # ========================================
 
 validate_configuration() {
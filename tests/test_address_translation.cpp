@@ -7,6 +7,9 @@
  * 3. Reconstructs PRA correctly
  * 4. Maintains identity mapping initially
  * 5. Correctly handles region swapping
+ * 6. Gives the same mappings with the sparse, identity-default table
+ * 7. Gives the same mappings with the hierarchical table, which scales to
+ *    terabyte-class geometries
  */
 
 #include <iostream>
@@ -14,7 +17,17 @@
 #include <cstdint>
 #include <map>
 
-// Simulate the key functions from ReRAMRegionMapper
+#include "../tools/region_table.h"
+
+// Region table layouts of ReRAMRegionMapper
+enum RegionTableMode {
+    TABLE_EAGER,         // Every (bank, VRN) entry filled at startup
+    TABLE_SPARSE,        // Only swapped entries stored, identity default
+    TABLE_HIERARCHICAL   // Directory + leaf pages allocated on demand
+};
+
+// Simulate the key functions from ReRAMRegionMapper. Keys are
+// bank * numRegionsPerBank + VRN, sized from the geometry.
 class TestRegionMapper {
 private:
     const int VRN_SHIFT = 6;
@@ -23,18 +36,67 @@ private:
     std::map<uint64_t, uint64_t> regionTable;
     std::map<uint64_t, uint64_t> inverseRegionTable;
 
-    uint64_t numBanks = 8;
-    uint64_t numRegionsPerBank = 1024;
+    RegionTableMode mode;
+    SparseRegionTable sparseRegionTable;
+    SparseRegionTable sparseInverseRegionTable;
+    HierarchicalRegionTable hierarchicalRegionTable;
+    HierarchicalRegionTable hierarchicalInverseRegionTable;
+
+    uint64_t numBanks;
+    uint64_t numRegionsPerBank;
+
+    uint64_t Key(uint64_t bank, uint64_t region) const {
+        return bank * numRegionsPerBank + region;
+    }
+
+    uint64_t LookupPRN(uint64_t bank, uint64_t VRN) {
+        if (mode == TABLE_HIERARCHICAL) {
+            return hierarchicalRegionTable.Get(bank, VRN);
+        } else if (mode == TABLE_SPARSE) {
+            return sparseRegionTable.Get(Key(bank, VRN), VRN);
+        }
+        return regionTable[Key(bank, VRN)];
+    }
+
+    void SetPRN(uint64_t bank, uint64_t VRN, uint64_t PRN) {
+        if (mode == TABLE_HIERARCHICAL) {
+            hierarchicalRegionTable.Set(bank, VRN, PRN);
+        } else if (mode == TABLE_SPARSE) {
+            sparseRegionTable.Set(Key(bank, VRN), PRN, VRN);
+        } else {
+            regionTable[Key(bank, VRN)] = PRN;
+        }
+    }
+
+    void SetVRN(uint64_t bank, uint64_t PRN, uint64_t VRN) {
+        if (mode == TABLE_HIERARCHICAL) {
+            hierarchicalInverseRegionTable.Set(bank, PRN, VRN);
+        } else if (mode == TABLE_SPARSE) {
+            sparseInverseRegionTable.Set(Key(bank, PRN), VRN, PRN);
+        } else {
+            inverseRegionTable[Key(bank, PRN)] = VRN;
+        }
+    }
 
 public:
-    TestRegionMapper() {
-        InitializeRegionTable();
+    explicit TestRegionMapper(RegionTableMode mode = TABLE_EAGER,
+                              uint64_t numBanks = 8,
+                              uint64_t numRegionsPerBank = 1024)
+        : mode(mode),
+          hierarchicalRegionTable(mode == TABLE_HIERARCHICAL ? numBanks : 0,
+                                  numRegionsPerBank),
+          hierarchicalInverseRegionTable(mode == TABLE_HIERARCHICAL ? numBanks : 0,
+                                         numRegionsPerBank),
+          numBanks(numBanks), numRegionsPerBank(numRegionsPerBank) {
+        if (mode == TABLE_EAGER) {
+            InitializeRegionTable();
+        }
     }
 
     void InitializeRegionTable() {
         for (uint64_t bank = 0; bank < numBanks; bank++) {
             for (uint64_t VRN = 0; VRN < numRegionsPerBank; VRN++) {
-                uint64_t key = (bank << 10) | VRN;
+                uint64_t key = Key(bank, VRN);
                 regionTable[key] = VRN;  // Identity mapping
                 inverseRegionTable[key] = VRN;
             }
@@ -47,8 +109,7 @@ public:
         uint64_t RO = VRA & RO_MASK;
 
         // Lookup PRN
-        uint64_t key = (bank << 10) | VRN;
-        uint64_t PRN = regionTable[key];
+        uint64_t PRN = LookupPRN(bank, VRN);
 
         // Reconstruct PRA
         uint64_t PRA = (PRN << VRN_SHIFT) | RO;
@@ -57,26 +118,44 @@ public:
     }
 
     void SwapRegions(uint64_t bank, uint64_t VRN_hot, uint64_t VRN_cold) {
-        uint64_t key_hot = (bank << 10) | VRN_hot;
-        uint64_t key_cold = (bank << 10) | VRN_cold;
-
-        uint64_t PRN_hot = regionTable[key_hot];
-        uint64_t PRN_cold = regionTable[key_cold];
+        uint64_t PRN_hot = LookupPRN(bank, VRN_hot);
+        uint64_t PRN_cold = LookupPRN(bank, VRN_cold);
 
         // Swap forward mappings
-        regionTable[key_hot] = PRN_cold;
-        regionTable[key_cold] = PRN_hot;
+        SetPRN(bank, VRN_hot, PRN_cold);
+        SetPRN(bank, VRN_cold, PRN_hot);
 
         // Update inverse mappings
-        uint64_t inv_key_hot = (bank << 10) | PRN_hot;
-        uint64_t inv_key_cold = (bank << 10) | PRN_cold;
-        inverseRegionTable[inv_key_hot] = VRN_cold;
-        inverseRegionTable[inv_key_cold] = VRN_hot;
+        SetVRN(bank, PRN_hot, VRN_cold);
+        SetVRN(bank, PRN_cold, VRN_hot);
     }
 
     uint64_t GetVRNFromPRN(uint64_t bank, uint64_t PRN) {
-        uint64_t key = (bank << 10) | PRN;
-        return inverseRegionTable[key];
+        if (mode == TABLE_HIERARCHICAL) {
+            return hierarchicalInverseRegionTable.Get(bank, PRN);
+        } else if (mode == TABLE_SPARSE) {
+            return sparseInverseRegionTable.Get(Key(bank, PRN), PRN);
+        }
+        return inverseRegionTable[Key(bank, PRN)];
+    }
+
+    // Forward and inverse entries held in memory
+    uint64_t StoredEntries() const {
+        if (mode == TABLE_HIERARCHICAL) {
+            return (hierarchicalRegionTable.Leaves()
+                    + hierarchicalInverseRegionTable.Leaves())
+                 * hierarchicalRegionTable.LeafSize();
+        } else if (mode == TABLE_SPARSE) {
+            return sparseRegionTable.Size() + sparseInverseRegionTable.Size();
+        }
+        return regionTable.size() + inverseRegionTable.size();
+    }
+
+    uint64_t MemoryBytes() const {
+        return hierarchicalRegionTable.MemoryBytes()
+             + hierarchicalInverseRegionTable.MemoryBytes()
+             + sparseRegionTable.MemoryBytes()
+             + sparseInverseRegionTable.MemoryBytes();
     }
 };
 
@@ -282,6 +361,126 @@ void test_fast_region_detection() {
     std::cout << "Test 6: PASSED ✓\n" << std::endl;
 }
 
+void test_sparse_region_table() {
+    std::cout << "Test 7: Sparse Identity-Default Region Table" << std::endl;
+
+    TestRegionMapper sparse(TABLE_SPARSE);
+    TestRegionMapper eager;
+    assert(sparse.StoredEntries() == 0);
+    assert(eager.StoredEntries() == 2 * 8 * 1024);
+    std::cout << "  Startup: sparse 0 entries, eager " << eager.StoredEntries()
+              << " entries ✓" << std::endl;
+
+    for (uint64_t VRA : {0, 64, 4096, 65535}) {
+        assert(sparse.Translate(3, VRA) == VRA);
+    }
+    std::cout << "  Unswapped regions translate to themselves ✓" << std::endl;
+
+    sparse.SwapRegions(0, 10, 20);
+    assert(sparse.StoredEntries() == 4);
+    assert(sparse.Translate(0, 10 << 6) == (20 << 6));
+    assert(sparse.GetVRNFromPRN(0, 20) == 10);
+    sparse.SwapRegions(0, 10, 20);
+    assert(sparse.StoredEntries() == 0);
+    assert(sparse.Translate(0, 10 << 6) == (10 << 6));
+    std::cout << "  One swap stores 4 entries, swapping back frees them ✓" << std::endl;
+
+    // Random swap sequence: both modes agree on every mapping
+    uint64_t state = 42;
+    for (int i = 0; i < 20000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t bank = (state >> 20) % 8;
+        uint64_t VRN_hot = (state >> 30) % 1024;
+        uint64_t VRN_cold = (state >> 45) % 64;
+        sparse.SwapRegions(bank, VRN_hot, VRN_cold);
+        eager.SwapRegions(bank, VRN_hot, VRN_cold);
+    }
+    for (uint64_t bank = 0; bank < 8; bank++) {
+        for (uint64_t region = 0; region < 1024; region++) {
+            assert(sparse.Translate(bank, (region << 6) | 7)
+                   == eager.Translate(bank, (region << 6) | 7));
+            assert(sparse.GetVRNFromPRN(bank, region) == eager.GetVRNFromPRN(bank, region));
+        }
+    }
+    std::cout << "  20000 random swaps: sparse == eager for all regions ("
+              << sparse.StoredEntries() << " entries stored) ✓" << std::endl;
+
+    // Table against std::map with inserts, updates and identity erases
+    SparseRegionTable table;
+    std::map<uint64_t, uint64_t> reference;
+    for (int i = 0; i < 100000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t key = (state >> 24) % 4096;
+        uint64_t value = ((state >> 40) % 4 == 0) ? key : (state >> 50);
+        table.Set(key, value, key);
+        if (value == key) {
+            reference.erase(key);
+        } else {
+            reference[key] = value;
+        }
+    }
+    assert(table.Size() == reference.size());
+    for (uint64_t key = 0; key < 4096; key++) {
+        auto it = reference.find(key);
+        assert(table.Get(key, key) == (it == reference.end() ? key : it->second));
+    }
+    std::cout << "  Hash table matches std::map after 100000 updates ✓" << std::endl;
+
+    std::cout << "Test 7: PASSED ✓\n" << std::endl;
+}
+
+void test_hierarchical_region_table() {
+    std::cout << "Test 8: Hierarchical Region Table" << std::endl;
+
+    TestRegionMapper hierarchical(TABLE_HIERARCHICAL);
+    TestRegionMapper eager;
+    assert(hierarchical.StoredEntries() == 0);
+    std::cout << "  Startup: no leaves allocated ✓" << std::endl;
+
+    uint64_t state = 7;
+    for (int i = 0; i < 20000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t bank = (state >> 20) % 8;
+        uint64_t VRN_hot = (state >> 30) % 1024;
+        uint64_t VRN_cold = (state >> 45) % 64;
+        hierarchical.SwapRegions(bank, VRN_hot, VRN_cold);
+        eager.SwapRegions(bank, VRN_hot, VRN_cold);
+    }
+    for (uint64_t bank = 0; bank < 8; bank++) {
+        for (uint64_t region = 0; region < 1024; region++) {
+            assert(hierarchical.Translate(bank, (region << 6) | 5)
+                   == eager.Translate(bank, (region << 6) | 5));
+            assert(hierarchical.GetVRNFromPRN(bank, region)
+                   == eager.GetVRNFromPRN(bank, region));
+        }
+    }
+    std::cout << "  20000 random swaps: hierarchical == eager ✓" << std::endl;
+
+    // 16 channels x 4 ranks x 16 banks, ROWS 2^20: 16384 regions per bank
+    // no longer fit the 10-bit VRN field of (bank << 10) | VRN
+    const uint64_t numBanks = 16 * 4 * 16;
+    const uint64_t regionsPerBank = (1ULL << 20) / 64;
+    TestRegionMapper large(TABLE_HIERARCHICAL, numBanks, regionsPerBank);
+
+    large.SwapRegions(1023, 16383, 2);
+    large.SwapRegions(0, 5000, 1);
+    assert(large.Translate(1023, 16383ULL << 6) == (2ULL << 6));
+    assert(large.Translate(1023, 2ULL << 6) == (16383ULL << 6));
+    assert(large.GetVRNFromPRN(0, 1) == 5000);
+    assert(large.Translate(1022, 16383ULL << 6) == (16383ULL << 6));
+    assert(large.Translate(1, 5000ULL << 6) == (5000ULL << 6));
+
+    uint64_t eagerBytes = 2 * numBanks * regionsPerBank * sizeof(uint32_t);
+    assert(large.MemoryBytes() < eagerBytes / 100);
+    std::cout << "  " << numBanks * regionsPerBank << " regions: "
+              << large.MemoryBytes() / 1024 << " KB instead of "
+              << eagerBytes / (1024 * 1024) << " MB for flat tables ✓" << std::endl;
+    std::cout << "  VRNs up to 16383 swapped in banks 0 and 1023, same VRNs in banks 1 "
+              << "and 1022 untouched ✓" << std::endl;
+
+    std::cout << "Test 8: PASSED ✓\n" << std::endl;
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "ReRAM Region Mapper Unit Tests" << std::endl;
@@ -293,6 +492,8 @@ int main() {
     test_inverse_mapping();
     test_multi_bank_isolation();
     test_fast_region_detection();
+    test_sparse_region_table();
+    test_hierarchical_region_table();
 
     std::cout << "========================================" << std::endl;
     std::cout << "ALL TESTS PASSED ✓✓✓" << std::endl;
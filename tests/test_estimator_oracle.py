@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+Analytical Estimator Cross-Check
+
+This test verifies that tools/analytical_estimator reproduces the epoch-level
+replay of tools/oracle_placement (online column, --policy threshold) on a
+generated trace:
+1. Both tools count the same fast region accesses
+2. The estimator's swaps equal the online policy's migrations
+
+The trace moves a skewed working set over random addresses every few
+epochs, so regions are promoted and demoted throughout. Several parameter
+sets are checked, each with its own NVMain configuration file.
+
+Usage:
+    python3 test_estimator_oracle.py [--estimator PATH] [--oracle PATH]
+                                     [--requests N]
+"""
+
+import argparse
+import csv
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+
+GEOMETRY = {
+    'CHANNELS': 2,
+    'RANKS': 2,
+    'BANKS': 8,
+    'ROWS': 65536,
+    'COLS': 4096,
+    'BusWidth': 64,
+    'MATHeight': 1024,
+    'RegionSize': 64,
+    'FastRegionsPerMat': 4,
+    'FastRegionLatency': 50,
+    'SlowRegionLatency': 120,
+}
+
+# Alpha, Beta, EpochLength, MigrationThreshold
+PARAMETER_SETS = [
+    (0.5, 0.5, 100000, 2.0),
+    (1.0, 0.3, 50000, 0.0),
+    (0.2, 1.0, 200000, 5.0),
+]
+
+
+def write_trace(path, requests, seed=1):
+    """Write an NVMain text trace with a working set that shifts over time"""
+    rng = random.Random(seed)
+    cycle = 0
+    hot = []
+    with open(path, 'w') as f:
+        f.write("NVMV1\n")
+        for i in range(requests):
+            if i % 50000 == 0:
+                hot = [rng.randrange(1 << 32) & ~63 for _ in range(300)]
+            cycle += rng.randrange(1, 20)
+            if rng.random() < 0.8:
+                address = rng.choice(hot)
+            else:
+                address = rng.randrange(1 << 32) & ~63
+            op = 'W' if rng.random() < 0.3 else 'R'
+            f.write(f"{cycle} {op} 0x{address:x} 0 0\n")
+
+
+def write_config(path, alpha, beta, epoch_length, threshold):
+    """Write an NVMain configuration with the given migration parameters"""
+    with open(path, 'w') as f:
+        for key, value in GEOMETRY.items():
+            f.write(f"{key} {value}\n")
+        f.write(f"Alpha {alpha}\n")
+        f.write(f"Beta {beta}\n")
+        f.write(f"EpochLength {epoch_length}\n")
+        f.write(f"MigrationThreshold {threshold}\n")
+
+
+def run_oracle(oracle, config, trace):
+    """Fast accesses and migrations of the online threshold policy"""
+    output = subprocess.run([oracle, '--config', config, '--trace', trace,
+                             '--policy', 'threshold'],
+                            check=True, capture_output=True, text=True).stdout
+    for line in output.splitlines():
+        fields = line.split()
+        if fields and fields[0] == 'online':
+            return int(fields[1]), int(fields[3])
+    raise ValueError("no online row in the oracle_placement output")
+
+
+def run_estimator(estimator, config, trace, csv_file):
+    """Fast accesses and swaps of the configuration's parameter set"""
+    subprocess.run([estimator, '--config', config, '--trace', trace,
+                    '--csv', csv_file],
+                   check=True, capture_output=True, text=True)
+    with open(csv_file, newline='') as f:
+        rows = list(csv.DictReader(f))
+    if len(rows) != 1:
+        raise ValueError(f"expected one estimate, found {len(rows)}")
+    return int(rows[0]['fastAccesses']), int(rows[0]['swaps'])
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare analytical_estimator with oracle_placement"
+    )
+
+    parser.add_argument('--estimator', default='tools/analytical_estimator',
+                        help='analytical_estimator binary')
+    parser.add_argument('--oracle', default='tools/oracle_placement',
+                        help='oracle_placement binary')
+    parser.add_argument('--requests', type=int, default=200000,
+                        help='Requests in the generated trace')
+
+    args = parser.parse_args()
+
+    print("=" * 50)
+    print("Analytical Estimator Cross-Check")
+    print("=" * 50)
+
+    failures = 0
+    with tempfile.TemporaryDirectory() as workdir:
+        trace = os.path.join(workdir, 'trace.nvt')
+        config = os.path.join(workdir, 'nvmain.config')
+        csv_file = os.path.join(workdir, 'estimates.csv')
+        write_trace(trace, args.requests)
+
+        for alpha, beta, epoch_length, threshold in PARAMETER_SETS:
+            write_config(config, alpha, beta, epoch_length, threshold)
+            oracle_fast, migrations = run_oracle(args.oracle, config, trace)
+            estimate_fast, swaps = run_estimator(args.estimator, config,
+                                                 trace, csv_file)
+
+            name = (f"Alpha {alpha} Beta {beta} EpochLength {epoch_length} "
+                    f"Threshold {threshold}")
+            if oracle_fast == estimate_fast and migrations == swaps:
+                print(f"  ✓ {name}: {estimate_fast} fast accesses, "
+                      f"{swaps} swaps")
+            else:
+                print(f"  ✗ {name}: online {oracle_fast} fast accesses, "
+                      f"{migrations} migrations; estimated {estimate_fast} "
+                      f"fast accesses, {swaps} swaps")
+                failures += 1
+
+    print()
+    if failures == 0:
+        print("ESTIMATES MATCH THE ONLINE REPLAY ✓✓✓")
+        sys.exit(0)
+
+    print(f"{failures} PARAMETER SETS DIFFER ✗")
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
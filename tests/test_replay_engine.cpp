@@ -0,0 +1,1207 @@
+/**
+ * Unit Test: Parallel Trace Replay
+ *
+ * This test verifies that the replay engine in tools/replay_engine.h:
+ * 1. Times a lone request as service latency plus one burst
+ * 2. Serializes requests to one bank and the channel data bus
+ * 3. Stalls requests when the controller queue is full
+ * 4. Produces statistics identical to the serial replay for any number of
+ *    threads and any block size
+ * 5. Charges metadata reads and write-backs of the mapping cache
+ * 6. Migrates through a spare region with the rotate scheme
+ * 7. Keeps in-bank region copies off the channel bus
+ * 8. Caps the aggregate migration bandwidth with the token bucket
+ * 9. Applies epoch decisions DecisionLatency cycles after the boundary
+ * 10. Publishes mapping snapshots that concurrent readers use without locks
+ * 11. Overlaps operations on different mat groups of a bank
+ * 12. Charges row hits, misses and conflicts under each page policy
+ * 13. Adds MLC program-and-verify time to writes from the written data
+ * 14. Scrubs rows in idle bank time and escalates overdue scrubs
+ * 15. Retires worn-out regions into spare regions
+ * 16. Charges ECC encode, decode, correction and pointer latency
+ * 17. Programs fewer MLC cells for compressed lines
+ * 18. Keeps tenants within their fast-region quotas, borrowing idle ones
+ */
+
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../tools/replay_engine.h"
+
+// 2 channels x 2 ranks x 8 banks, 64-row regions, 4 of 16 fast per mat
+RegionGeometry make_geometry() {
+    RegionGeometry geometry;
+    assert(geometry.Initialize());
+    return geometry;
+}
+
+ReplayParams make_params() {
+    ReplayParams params;
+    params.epochLength = 100000;
+    params.fastLatency = 50;
+    params.slowLatency = 120;
+    params.swapCost = 500;
+    params.queueSize = 4;
+    params.burstCycles = 4;
+    params.policyParams.migrationThreshold = 2.0;
+    params.policyParams.swapCost = 500.0;
+    return params;
+}
+
+TraceRequest make_request(uint64_t cycle, uint64_t address, uint8_t op) {
+    TraceRequest request;
+    request.cycle = cycle;
+    request.address = address;
+    request.dataHash = 0;
+    request.size = 64;
+    request.requestor = 0;
+    request.op = op;
+    request.lineBytes = 0;
+    return request;
+}
+
+// Address of a row in (channel 0, rank 0, bank 0) for the R:RK:BK:CH:C order
+uint64_t row_address(const RegionGeometry& geometry, uint64_t row) {
+    uint64_t rowBytes = geometry.cols * geometry.busWidth / 8;
+    return row * rowBytes * geometry.channels * geometry.banks * geometry.ranks;
+}
+
+// Replays the trace serially and on the given threads in blocks of requests,
+// asserts that both give the same stats and returns them
+ReplayStats expect_parallel_identical(const RegionGeometry& geometry,
+                                      const ReplayParams& params,
+                                      const std::vector<TraceRequest>& requests,
+                                      uint64_t threads, uint64_t block) {
+    ReplaySerial serial(geometry, params);
+    serial.Replay(requests.data(), requests.size());
+    ReplayEngine engine(geometry, params, threads);
+    for (uint64_t i = 0; i < requests.size(); i += block) {
+        engine.Replay(requests.data() + i, std::min<uint64_t>(block, requests.size() - i));
+    }
+    assert(engine.Stats() == serial.Stats());
+    return serial.Stats();
+}
+
+void test_single_request() {
+    std::cout << "Test 1: Lone Request Timing" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+
+    // Row 0 is in PRN 0 (fast), row 64 * 5 in PRN 5 (slow)
+    std::vector<TraceRequest> requests;
+    requests.push_back(make_request(100, row_address(geometry, 0), TRACE_READ));
+    requests.push_back(make_request(1000, row_address(geometry, 64 * 5), TRACE_READ));
+
+    ReplaySerial serial(geometry, params);
+    serial.Replay(requests.data(), requests.size());
+    ReplayStats stats = serial.Stats();
+
+    assert(stats.fastAccesses == 1 && stats.slowAccesses == 1);
+    assert(stats.totalLatency == (50 + 4) + (120 + 4));
+    assert(stats.queueCycles == 0 && stats.bankCycles == 0 && stats.busCycles == 0);
+    assert(stats.lastCompletion == 1000 + 120 + 4);
+    std::cout << "  Fast: 50 + 4, slow: 120 + 4 cycles ✓" << std::endl;
+
+    std::cout << "Test 1: PASSED ✓\n" << std::endl;
+}
+
+void test_bank_and_bus() {
+    std::cout << "Test 2: Bank and Bus Contention" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+
+    // Two requests to the same bank at the same cycle
+    std::vector<TraceRequest> requests;
+    requests.push_back(make_request(0, row_address(geometry, 0), TRACE_READ));
+    requests.push_back(make_request(0, row_address(geometry, 1), TRACE_READ));
+
+    ReplaySerial sameBank(geometry, params);
+    sameBank.Replay(requests.data(), requests.size());
+    assert(sameBank.Stats().bankCycles == 50);
+    assert(sameBank.Stats().lastCompletion == 50 + 50 + 4);
+    std::cout << "  Second request waits for the bank ✓" << std::endl;
+
+    // Two requests to different banks of channel 0 share the bus
+    uint64_t rowBytes = geometry.cols * geometry.busWidth / 8;
+    requests[1].address = rowBytes * geometry.channels;
+    ReplaySerial sameBus(geometry, params);
+    sameBus.Replay(requests.data(), requests.size());
+    assert(sameBus.Stats().bankCycles == 0);
+    assert(sameBus.Stats().busCycles == 4);
+    std::cout << "  Different bank: waits one burst for the bus ✓" << std::endl;
+
+    // Different channels do not interact
+    requests[1].address = rowBytes;
+    ReplaySerial otherChannel(geometry, params);
+    otherChannel.Replay(requests.data(), requests.size());
+    assert(otherChannel.Stats().bankCycles == 0);
+    assert(otherChannel.Stats().busCycles == 0);
+    std::cout << "  Different channel: no contention ✓" << std::endl;
+
+    std::cout << "Test 2: PASSED ✓\n" << std::endl;
+}
+
+void test_queue_full() {
+    std::cout << "Test 3: Controller Queue Full" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    uint64_t rowBytes = geometry.cols * geometry.busWidth / 8;
+
+    // Five requests to five banks of channel 0 at cycle 0, queue of 4
+    std::vector<TraceRequest> requests;
+    for (uint64_t bank = 0; bank < 5; bank++) {
+        uint64_t address = bank * rowBytes * geometry.channels;
+        requests.push_back(make_request(0, address, TRACE_READ));
+    }
+
+    ReplaySerial serial(geometry, params);
+    serial.Replay(requests.data(), requests.size());
+
+    // The fifth request is admitted when the first completes at 54
+    assert(serial.Stats().queueCycles == 54);
+    std::cout << "  Fifth request waits for the first completion ✓" << std::endl;
+
+    std::cout << "Test 3: PASSED ✓\n" << std::endl;
+}
+
+// Skewed random accesses over the whole memory, with idle phases. The hot
+// addresses start at region 8 (slow) of every bank.
+std::vector<TraceRequest> make_skewed_trace(const RegionGeometry& geometry) {
+    std::vector<TraceRequest> requests;
+    uint64_t hotBase = row_address(geometry, 64 * 8);
+    uint64_t state = 12345, cycle = 0;
+    uint64_t memory = geometry.channels * geometry.ranks * geometry.banks
+                    * geometry.rows * geometry.cols * geometry.busWidth / 8;
+    for (uint64_t i = 0; i < 100000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t random = state >> 16;
+        cycle += (i % 25000 < 20000) ? (random % 8) : (random % 2000);
+        uint64_t address = (random % 64 < 48) ? hotBase + random % (memory / 256)
+                                              : random % memory;
+        requests.push_back(make_request(cycle, address & ~63ULL,
+                                        (random >> 40) % 3 == 0 ? TRACE_WRITE
+                                                                : TRACE_READ));
+    }
+    return requests;
+}
+
+void test_parallel_identical() {
+    std::cout << "Test 4: Parallel Replay Matches Serial Replay" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+
+    for (const char *policy : {"threshold", "linear"}) {
+        params.policy = policy;
+
+        ReplayStats reference;
+        const uint64_t configs[][2] = {{1, 65536}, {2, 1000}, {3, 4097}, {8, 333}};
+        for (const auto& config : configs) {
+            reference = expect_parallel_identical(geometry, params, requests,
+                                                  config[0], config[1]);
+        }
+        assert(reference.requests == requests.size());
+        assert(reference.migrations > 0 && reference.queueCycles > 0);
+        std::cout << "  " << policy << ": " << reference.migrations
+                  << " swaps, 1-8 threads, blocks of 333-65536 identical ✓"
+                  << std::endl;
+    }
+
+    std::cout << "Test 4: PASSED ✓\n" << std::endl;
+}
+
+void test_mapping_cache() {
+    std::cout << "Test 5: Mapping Cache" << std::endl;
+
+    // 2 sets x 2 ways, LRU
+    MappingCache cache;
+    cache.Configure(4, 2);
+    assert(!cache.Access(0, false).hit);
+    assert(!cache.Access(2, true).hit);
+    assert(cache.Access(0, false).hit);
+    MappingCacheResult result = cache.Access(4, false);   // Evicts dirty line 2
+    assert(!result.hit && result.writeback);
+    assert(cache.Access(0, false).hit);
+    result = cache.Access(6, false);                        // Evicts clean line 4
+    assert(!result.hit && !result.writeback);
+    std::cout << "  LRU replacement, dirty lines written back on eviction ✓" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.mappingCacheEntries = geometry.NumBanks() * 16;  // One line per bank
+    params.mappingCacheAssoc = 1;
+    params.mappingEntriesPerLine = 16;
+    params.metadataReadLatency = 30;
+    params.metadataWriteLatency = 70;
+
+    // Bank 0, all fast: regions 0, 0 (hit), 16 (miss, other line), 0 (miss)
+    std::vector<TraceRequest> requests;
+    for (uint64_t region : {0, 0, 16, 0}) {
+        uint64_t cycle = 1000 * (requests.size() + 1);
+        requests.push_back(make_request(cycle, row_address(geometry, 64 * region),
+                                        TRACE_READ));
+    }
+
+    ReplaySerial serial(geometry, params);
+    serial.Replay(requests.data(), requests.size());
+    ReplayStats stats = serial.Stats();
+    assert(stats.mappingHits == 1 && stats.mappingMisses == 3);
+    assert(stats.metadataReads == 3 && stats.metadataWrites == 0);
+    assert(stats.totalLatency == 4 * (50 + 4) + 3 * 30);
+    std::cout << "  Misses add MetadataReadLatency to the access ✓" << std::endl;
+
+    // With the cache, replay is still identical across threads
+    std::vector<TraceRequest> trace;
+    uint64_t state = 99, cycle = 0;
+    for (uint64_t i = 0; i < 50000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t random = state >> 16;
+        cycle += random % 16;
+        uint64_t row = (random % 4 == 0) ? random % geometry.rows : 64 * 9 + random % 64;
+        uint64_t address = row_address(geometry, row)
+                         + (random >> 32) % 32 * (geometry.cols * geometry.busWidth / 8);
+        trace.push_back(make_request(cycle, address,
+                                     (random >> 40) % 2 ? TRACE_WRITE : TRACE_READ));
+    }
+    params.mappingCacheEntries = geometry.NumBanks() * 256;
+    params.mappingCacheAssoc = 4;
+
+    ReplayStats reference = expect_parallel_identical(geometry, params, trace,
+                                                      4, trace.size());
+    assert(reference.migrations > 0);
+    assert(reference.metadataWrites > 0);
+    std::cout << "  Swaps dirty metadata lines (" << reference.metadataWrites
+              << " write-backs), parallel replay identical ✓" << std::endl;
+
+    std::cout << "Test 5: PASSED ✓\n" << std::endl;
+}
+
+void test_rotate_migration() {
+    std::cout << "Test 6: Free-Region Rotation" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+
+    // A rotation is two region copies, slow -> fast and fast -> spare (slow)
+    const uint64_t copyCycles = geometry.regionSize
+                              * (params.fastLatency + params.slowLatency);
+    params.swapCost = 2 * copyCycles;
+
+    ReplaySerial swap(geometry, params);
+    swap.Replay(requests.data(), requests.size());
+
+    params.migrationScheme = "rotate";
+    ReplaySerial rotate(geometry, params);
+    rotate.Replay(requests.data(), requests.size());
+    ReplayStats stats = rotate.Stats();
+
+    assert(stats.migrations > 0);
+    assert(stats.rowsMoved == stats.migrations * 2 * geometry.regionSize);
+    assert(stats.migrationCycles == stats.migrations * 2 * copyCycles);
+    std::cout << "  " << stats.migrations << " rotations, two region copies each ✓"
+              << std::endl;
+
+    // The spare is never a fast region, so placement matches the swaps
+    assert(stats.migrations == swap.Stats().migrations);
+    assert(stats.fastAccesses == swap.Stats().fastAccesses);
+    assert(stats.rowsMoved == swap.Stats().rowsMoved);
+    std::cout << "  Same fast hits and rows moved as equal-cost swaps ✓" << std::endl;
+
+    assert(expect_parallel_identical(geometry, params, requests, 3, 4097) == stats);
+    std::cout << "  Parallel replay identical ✓" << std::endl;
+
+    std::cout << "Test 6: PASSED ✓\n" << std::endl;
+}
+
+void test_in_bank_copy() {
+    std::cout << "Test 7: In-Bank Region Copy" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.migrationRowBusCycles = 8;
+    params.rowMoveEnergy = 300;
+    params.rowCloneEnergy = 100;
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+
+    // Through the controller every moved row crosses the bus twice
+    ReplaySerial channel(geometry, params);
+    channel.Replay(requests.data(), requests.size());
+    ReplayStats moved = channel.Stats();
+    assert(moved.migrations > 0 && moved.rowsCloned == 0);
+    assert(moved.migrationBusCycles == moved.rowsMoved * 2 * 8);
+    assert(moved.migrationEnergy == moved.rowsMoved * 300);
+    std::cout << "  Controller copies: " << moved.migrationBusCycles
+              << " bus cycles ✓" << std::endl;
+
+    // The transfers of bank 0's swap delay a request to another bank of
+    // the channel, though bank 0 is never accessed again
+    std::vector<TraceRequest> pair;
+    for (uint64_t i = 0; i < 10; i++) {
+        pair.push_back(make_request(1000 * i, row_address(geometry, 64 * 5), TRACE_READ));
+    }
+    uint64_t otherBank = geometry.cols * geometry.busWidth / 8 * geometry.channels;
+    pair.push_back(make_request(100010, row_address(geometry, 0) + otherBank, TRACE_READ));
+    ReplaySerial transfer(geometry, params);
+    transfer.Replay(pair.data(), pair.size());
+    assert(transfer.Stats().migrations == 1);
+    assert(transfer.Stats().busCycles == 100000 + 2 * 128 * 8 - (100010 + 50));
+    std::cout << "  Transfers hold the bus from the migration's start ✓" << std::endl;
+
+    // In the bank: no bus transfers, three row copies per swapped row pair
+    params.inBankCopy = true;
+    ReplaySerial swap(geometry, params);
+    swap.Replay(requests.data(), requests.size());
+    ReplayStats cloned = swap.Stats();
+    assert(cloned.migrations > 0 && cloned.migrationBusCycles == 0);
+    assert(cloned.rowsCloned == cloned.migrations * 3 * geometry.regionSize);
+    assert(cloned.migrationEnergy == cloned.rowsCloned * 100);
+    assert(cloned.busCycles < moved.busCycles);
+    std::cout << "  Swaps: " << cloned.rowsCloned << " rows cloned, "
+              << cloned.busCycles << " vs " << moved.busCycles
+              << " demand bus wait cycles ✓" << std::endl;
+
+    // Rotation needs two copies per row
+    params.migrationScheme = "rotate";
+    ReplaySerial rotate(geometry, params);
+    rotate.Replay(requests.data(), requests.size());
+    ReplayStats stats = rotate.Stats();
+    assert(stats.rowsCloned == stats.migrations * 2 * geometry.regionSize);
+    std::cout << "  Rotations: two copies per row ✓" << std::endl;
+
+    for (bool inBank : {false, true}) {
+        params.inBankCopy = inBank;
+        expect_parallel_identical(geometry, params, requests, 4, 1000);
+    }
+    std::cout << "  Parallel replay identical for both copy paths ✓" << std::endl;
+
+    std::cout << "Test 7: PASSED ✓\n" << std::endl;
+}
+
+void test_migration_budget() {
+    std::cout << "Test 8: Global Migration Budget" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.migrationRowBusCycles = 2;
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+
+    // Unlimited: the migrations of all banks start at the epoch boundary
+    ReplaySerial unlimited(geometry, params);
+    unlimited.Replay(requests.data(), requests.size());
+    assert(unlimited.Stats().migrations > 0);
+    assert(unlimited.Stats().migrationDelay == 0);
+    std::cout << "  Unlimited bandwidth: no migration waits for tokens ✓" << std::endl;
+
+    // One burst of tokens: of two swaps at the same boundary, the second
+    // waits for its 128 rows of tokens
+    std::vector<TraceRequest> pair;
+    uint64_t otherBank = geometry.cols * geometry.busWidth / 8 * geometry.channels;
+    for (uint64_t i = 0; i < 10; i++) {
+        pair.push_back(make_request(1000 * i, row_address(geometry, 64 * 5), TRACE_READ));
+        pair.push_back(make_request(1000 * i, row_address(geometry, 64 * 5) + otherBank,
+                                    TRACE_READ));
+    }
+    pair.push_back(make_request(150000, row_address(geometry, 0), TRACE_READ));
+    params.migrationTokenCycles = 10;
+    params.migrationTokenBurst = 2 * geometry.regionSize;
+    ReplaySerial burst(geometry, params);
+    burst.Replay(pair.data(), pair.size());
+    assert(burst.Stats().migrations == 2);
+    assert(burst.Stats().migrationDelay == 2 * geometry.regionSize * 10);
+    std::cout << "  Second burst-sized migration waits rows x MigrationTokenCycles ✓"
+              << std::endl;
+
+    // A smaller budget delays migrations more, but moves the same rows
+    uint64_t lastDelay = 0;
+    for (uint64_t tokenCycles : {1, 4, 16}) {
+        params.migrationTokenCycles = tokenCycles;
+        params.migrationTokenBurst = 2 * geometry.regionSize;
+
+        ReplayStats stats;
+        const uint64_t configs[][2] = {{1, 100000}, {2, 777}, {4, 5000}};
+        for (const auto& config : configs) {
+            stats = expect_parallel_identical(geometry, params, requests,
+                                              config[0], config[1]);
+        }
+        assert(stats.migrations == unlimited.Stats().migrations);
+        assert(stats.rowsMoved == unlimited.Stats().rowsMoved);
+        assert(stats.migrationDelay > lastDelay);
+        lastDelay = stats.migrationDelay;
+        std::cout << "  " << tokenCycles << " cycles per row: " << stats.migrationDelay
+                  << " delay cycles, parallel replay identical ✓" << std::endl;
+    }
+
+    std::cout << "Test 8: PASSED ✓\n" << std::endl;
+}
+
+void test_decision_latency() {
+    std::cout << "Test 9: Epoch Decision Latency" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.epochLength = 1000;
+    params.decisionLatency = 100;
+
+    // Region 8 of bank 0 (slow) is hot in epoch 0, then read at 1010
+    // (decision pending) and at 1200 (applied, swap started at 1100)
+    std::vector<TraceRequest> requests;
+    for (uint64_t i = 0; i < 6; i++) {
+        requests.push_back(make_request(125 * i, row_address(geometry, 64 * 8),
+                                        TRACE_READ));
+    }
+    requests.push_back(make_request(1010, row_address(geometry, 64 * 8), TRACE_READ));
+    requests.push_back(make_request(1200, row_address(geometry, 64 * 8), TRACE_READ));
+
+    ReplaySerial serial(geometry, params);
+    serial.Replay(requests.data(), requests.size() - 1);
+    assert(serial.Stats().slowAccesses == 7 && serial.Stats().migrations == 0);
+    std::cout << "  Before the apply cycle the old mapping is used ✓" << std::endl;
+
+    serial.Replay(requests.data() + requests.size() - 1, 1);
+    ReplayStats stats = serial.Stats();
+    assert(stats.migrations == 1 && stats.fastAccesses == 1);
+    // The swap waits for the bank to finish the read at 1010
+    assert(stats.lastCompletion == 1010 + 120 + 500 + 50 + 4);
+    std::cout << "  After it the region is fast, behind the swap ✓" << std::endl;
+
+    // Decisions on helper threads give the same result as inline ones
+    requests = make_skewed_trace(geometry);
+    params = make_params();
+    params.migrationTokenCycles = 2;
+    for (uint64_t latency : {0, 1, 5000, 99999}) {
+        params.decisionLatency = latency;
+        ReplayStats reference;
+        const uint64_t configs[][2] = {{1, 100000}, {3, 999}, {8, 4096}};
+        for (const auto& config : configs) {
+            reference = expect_parallel_identical(geometry, params, requests,
+                                                  config[0], config[1]);
+        }
+        assert(reference.migrations > 0);
+        std::cout << "  Latency " << latency << ": " << reference.migrations
+                  << " swaps, parallel replay identical ✓" << std::endl;
+    }
+
+    std::cout << "Test 9: PASSED ✓\n" << std::endl;
+}
+
+struct CountedSnapshot {
+    static int live;
+    CountedSnapshot() { live++; }
+    ~CountedSnapshot() { live--; }
+};
+int CountedSnapshot::live = 0;
+
+void test_mapping_snapshots() {
+    std::cout << "Test 10: Mapping Snapshots" << std::endl;
+
+    // A snapshot retired while a reader is in a section outlives the section
+    {
+        SnapshotDomain domain;
+        SnapshotPublisher<CountedSnapshot> publisher(domain);
+        SnapshotReader reader(domain);
+        assert(reader.Registered());
+
+        publisher.Publish(new CountedSnapshot());
+        {
+            SnapshotReader::Section section(reader);
+            const CountedSnapshot *first = publisher.Read();
+            publisher.Publish(new CountedSnapshot());
+            publisher.Publish(new CountedSnapshot());
+            assert(publisher.Read() != first);
+            assert(CountedSnapshot::live == 3 && publisher.Retained() == 2);
+        }
+        publisher.Reclaim();
+        assert(CountedSnapshot::live == 1 && publisher.Retained() == 0);
+    }
+    assert(CountedSnapshot::live == 0);
+    std::cout << "  Retired snapshots freed after the last reader leaves ✓" << std::endl;
+
+    // A reader thread checks every snapshot while the replay runs
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.epochLength = 20000;
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+
+    ReplaySerial reference(geometry, params);
+    reference.Replay(requests.data(), requests.size());
+
+    ReplayEngine engine(geometry, params, 2);
+    std::atomic<bool> done(false);
+    uint64_t reads = 0;
+    std::thread monitor([&]() {
+        SnapshotReader reader(engine.Snapshots());
+        std::vector<uint64_t> versions(geometry.NumBanks(), 0);
+        while (!done.load()) {
+            SnapshotReader::Section section(reader);
+            for (uint64_t bank = 0; bank < geometry.NumBanks(); bank++) {
+                const MappingSnapshot *snapshot = engine.Mapping(bank).Read();
+                assert(snapshot->version >= versions[bank]);
+                versions[bank] = snapshot->version;
+
+                // Always a complete table: an injective mapping
+                std::vector<bool> used(geometry.RegionsPerBank() + 1, false);
+                for (uint64_t PRN : snapshot->PRN) {
+                    assert(PRN <= geometry.RegionsPerBank() && !used[PRN]);
+                    used[PRN] = true;
+                }
+            }
+            reads++;
+            std::this_thread::yield();
+        }
+    });
+    for (uint64_t i = 0; i < requests.size(); i += 2000) {
+        engine.Replay(requests.data() + i, std::min<uint64_t>(2000, requests.size() - i));
+    }
+    done.store(true);
+    monitor.join();
+
+    assert(engine.Stats() == reference.Stats());
+    uint64_t versions = 0;
+    for (uint64_t bank = 0; bank < geometry.NumBanks(); bank++) {
+        versions += engine.Mapping(bank).Read()->version;
+    }
+    assert(versions > 0);
+    std::cout << "  " << reads << " concurrent reads of " << versions
+              << " table versions, replay unchanged ✓" << std::endl;
+
+    std::cout << "Test 10: PASSED ✓\n" << std::endl;
+}
+
+void test_mat_parallelism() {
+    std::cout << "Test 11: Mat-Level Parallelism" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.matGroups = 2;
+
+    // Bank 0 at cycle 0: rows 0 and 1 share mat 0, row 1024 is in mat 1
+    std::vector<TraceRequest> requests;
+    requests.push_back(make_request(0, row_address(geometry, 0), TRACE_READ));
+    requests.push_back(make_request(0, row_address(geometry, 1), TRACE_READ));
+
+    ReplaySerial sameMat(geometry, params);
+    sameMat.Replay(requests.data(), requests.size());
+    assert(sameMat.Stats().bankCycles == 50);
+    assert(sameMat.Stats().bankActiveCycles == 100);
+    std::cout << "  Same mat: second request waits for the mat ✓" << std::endl;
+
+    requests[1].address = row_address(geometry, geometry.matHeight);
+    ReplaySerial otherMat(geometry, params);
+    otherMat.Replay(requests.data(), requests.size());
+    ReplayStats stats = otherMat.Stats();
+    assert(stats.bankCycles == 0 && stats.busCycles == 4);
+    assert(stats.matBusyCycles == 100 && stats.bankActiveCycles == 50);
+    std::cout << "  Other mat group: overlapped, " << stats.matBusyCycles
+              << " busy cycles in " << stats.bankActiveCycles << " active ✓" << std::endl;
+
+    params.matGroups = 1;
+    ReplaySerial serialBank(geometry, params);
+    serialBank.Replay(requests.data(), requests.size());
+    assert(serialBank.Stats().bankCycles == 50);
+    std::cout << "  MatGroups 1 serializes the bank ✓" << std::endl;
+
+    // Mat groups and mat-aware placement replay identically in parallel
+    requests = make_skewed_trace(geometry);
+    params.matGroups = 16;
+    for (bool spread : {false, true}) {
+        params.matAwarePlacement = spread;
+        ReplayStats expected = expect_parallel_identical(geometry, params, requests,
+                                                         3, 3000);
+        assert(expected.migrations > 0);
+        assert(expected.matBusyCycles > expected.bankActiveCycles);
+        std::cout << "  16 groups" << (spread ? ", mat-aware placement" : "")
+                  << ": overlap " << static_cast<double>(expected.matBusyCycles)
+                                     / expected.bankActiveCycles
+                  << ", parallel replay identical ✓" << std::endl;
+    }
+
+    std::cout << "Test 11: PASSED ✓\n" << std::endl;
+}
+
+void test_row_buffer() {
+    std::cout << "Test 12: Row Buffer and Page Policies" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+
+    // Bank 0, fast region 0, one request every 1000 cycles
+    auto replay = [&](const std::vector<uint64_t>& rows) {
+        std::vector<TraceRequest> requests;
+        for (uint64_t row : rows) {
+            uint64_t cycle = 1000 * (requests.size() + 1);
+            requests.push_back(make_request(cycle, row_address(geometry, row),
+                                            TRACE_READ));
+        }
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+
+    ReplayStats stats = replay({0, 0, 1});
+    assert(stats.fastRowMisses == 3 && stats.fastRowHits == 0);
+    assert(stats.totalLatency == 3 * (50 + 4));
+    std::cout << "  closed: every access is a row miss ✓" << std::endl;
+
+    params.pagePolicy = "open";
+    stats = replay({0, 0, 1});
+    assert(stats.fastRowMisses == 1 && stats.fastRowHits == 1
+           && stats.fastRowConflicts == 1);
+    assert(stats.totalLatency == (50 + 4) + (20 + 4) + (70 + 4));
+    std::cout << "  open: miss, hit, conflict ✓" << std::endl;
+
+    // Two conflicts close the row, repeated accesses to row 3 reopen it
+    params.pagePolicy = "adaptive";
+    stats = replay({0, 1, 2, 3, 3, 3, 3, 3});
+    assert(stats.fastRowMisses == 4 && stats.fastRowConflicts == 2
+           && stats.fastRowHits == 2);
+    std::cout << "  adaptive: closes after conflicts, reopens on locality ✓" << std::endl;
+
+    // Slow regions have their own latencies and counters
+    stats = replay({64 * 5, 64 * 5});
+    assert(stats.slowRowMisses == 1 && stats.slowRowHits == 1);
+    assert(stats.totalLatency == (120 + 4) + (20 + 4));
+    std::cout << "  Slow region row hit ✓" << std::endl;
+
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+    params.policyParams.rowHitDiscount = 0.25;
+    for (const char *policy : {"open", "adaptive"}) {
+        params.pagePolicy = policy;
+        ReplayStats reference = expect_parallel_identical(geometry, params, requests,
+                                                          4, 2500);
+        assert(reference.migrations > 0);
+    }
+    std::cout << "  Parallel replay identical with open pages ✓" << std::endl;
+
+    std::cout << "Test 12: PASSED ✓\n" << std::endl;
+}
+
+void test_mlc_writes() {
+    std::cout << "Test 13: MLC Program-and-Verify Writes" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.mlcWrites = true;
+
+    // Level 0 takes 1 pulse, level 1 takes 3, level 2 takes 5, level 3 2
+    const uint8_t pulses[MLCParams::LEVELS] = {1, 3, 5, 2};
+    for (uint64_t level = 0; level < MLCParams::LEVELS; level++) {
+        for (uint64_t entry = 0; entry < MLCParams::ENTRIES; entry++) {
+            params.mlc.iterations[level][entry] = pulses[level];
+        }
+    }
+
+    auto replay = [&](uint64_t row, uint64_t data, uint8_t op) {
+        std::vector<TraceRequest> requests;
+        requests.push_back(make_request(1000, row_address(geometry, row), op));
+        requests.back().dataHash = data;
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+
+    // Data 4 is all level 0 cells except one at level 1; 0x5...56 is all
+    // level 1 cells except one at level 2
+    ReplayStats stats = replay(0, 4, TRACE_WRITE);
+    assert(stats.mlcIterations == 3 && stats.mlcProgramCycles == 60);
+    assert(stats.totalLatency == 50 + 3 * 20 + 4);
+    std::cout << "  Write ends when its slowest cell verifies ✓" << std::endl;
+
+    stats = replay(0, 0x5555555555555556ULL, TRACE_WRITE);
+    assert(stats.mlcIterations == 5);
+    stats = replay(0, 4, TRACE_READ);
+    assert(stats.mlcIterations == 0 && stats.totalLatency == 50 + 4);
+    std::cout << "  Pulses depend on the data, reads unaffected ✓" << std::endl;
+
+    // 150% of 3 pulses in a slow region, rounded up
+    stats = replay(64 * 5, 4, TRACE_WRITE);
+    assert(stats.mlcIterations == 5);
+    assert(stats.totalLatency == 120 + 5 * 20 + 4);
+    std::cout << "  Slow regions need more pulses ✓" << std::endl;
+
+    // Default distributions: deterministic and within the table bounds
+    params.mlc = MLCParams();
+    MLCWriteModel model(params.mlc);
+    uint64_t total = 0;
+    for (uint64_t data = 1; data <= 1000; data++) {
+        uint64_t hash = data * 0x9E3779B97F4A7C15ULL;
+        uint64_t iterations = model.Iterations(hash, data, true);
+        assert(iterations == model.Iterations(hash, data, true));
+        assert(iterations >= 2 && iterations <= 6);
+        total += iterations;
+    }
+    assert(model.Iterations(0, 7, true) <= 2);
+    assert(total > 4 * 1000);
+    std::cout << "  Random data mostly waits for the intermediate levels ✓" << std::endl;
+
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+    ReplayStats reference = expect_parallel_identical(geometry, params, requests, 4, 2500);
+    assert(reference.mlcIterations > 0);
+    std::cout << "  Parallel replay identical with MLC writes ✓" << std::endl;
+
+    std::cout << "Test 13: PASSED ✓\n" << std::endl;
+}
+
+void test_scrubbing() {
+    std::cout << "Test 14: Drift Scrubbing" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    const uint64_t rows = geometry.RegionsPerBank() * geometry.regionSize;
+
+    // One row released every 100 cycles
+    params.scrubInterval = rows * 100;
+    params.fastScrubLatency = 50;
+    params.slowScrubLatency = 60;
+
+    auto replay = [&](const std::vector<uint64_t>& cycles) {
+        std::vector<TraceRequest> requests;
+        for (uint64_t cycle : cycles) {
+            requests.push_back(make_request(cycle, row_address(geometry, 0), TRACE_READ));
+        }
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+
+    // Rows 0-9 fit before the request, row 10 would delay it
+    ReplayStats stats = replay({1000});
+    assert(stats.scrubRows == 10 && stats.scrubCycles == 10 * 50);
+    assert(stats.scrubEscalations == 0 && stats.scrubDelay == 0);
+    assert(stats.totalLatency == 50 + 4);
+    std::cout << "  Scrubs fill idle time without delaying demand ✓" << std::endl;
+
+    // A full pass, then fast rows 0-9 of the second pass
+    stats = replay({params.scrubInterval + 1000});
+    assert(stats.scrubRows == rows + 10);
+    params.scrubFastPasses = 2;
+    stats = replay({params.scrubInterval + 1000});
+    assert(stats.scrubRows == rows);
+    std::cout << "  Fast regions scrubbed every ScrubFastPasses passes ✓" << std::endl;
+
+    // The busy bank leaves no idle time for row 0, it runs once overdue
+    params.scrubFastPasses = 1;
+    stats = replay({0, 50});
+    assert(stats.scrubRows == 0 && stats.totalLatency == 2 * (50 + 4));
+    params.scrubDeadline = 1;
+    stats = replay({0, 50});
+    assert(stats.scrubRows == 1 && stats.scrubEscalations == 1);
+    assert(stats.scrubDelay == 50);
+    assert(stats.totalLatency == (50 + 4) + (50 + 50 + 4));
+    std::cout << "  Overdue scrubs escalate and delay demand ✓" << std::endl;
+
+    // Region 0 wears out on its third write and is retired into the slow
+    // spare at the first boundary. From then on its rows are scrubbed in
+    // the spare, at the slow latency, and worn PRN 0 is no longer scrubbed:
+    // rows 40-63 of the first pass, all of the second and 0-9 of the third.
+    params.scrubDeadline = 0;
+    auto slowRows = [](const ReplayStats& stats) {
+        return (stats.scrubCycles - 50 * stats.scrubRows) / (60 - 50);
+    };
+    std::vector<uint64_t> cycles = {1000, 2000, 3000, 4000, 2 * params.scrubInterval + 1000};
+    ReplayStats intact = replay(cycles);
+    params.enduranceWrites = 3;
+    params.spareRegions = 1;
+    auto writes = [&]() {
+        std::vector<TraceRequest> requests;
+        for (uint64_t cycle : cycles) {
+            requests.push_back(make_request(cycle, row_address(geometry, 0),
+                                            cycle < 4000 ? TRACE_WRITE : TRACE_READ));
+        }
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+    stats = writes();
+    assert(stats.regionsRetired == 1);
+    assert(stats.scrubRows == intact.scrubRows && stats.scrubEscalations == 0);
+    assert(slowRows(stats) == slowRows(intact) + 24 + 64 + 10);
+    params.enduranceWrites = 0;
+    params.spareRegions = 0;
+    std::cout << "  A retired region is scrubbed in its spare ✓" << std::endl;
+
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+    params.scrubInterval = rows * 200;
+    params.scrubDeadline = 200;
+    params.slowScrubLatency = 120;
+    for (const char *scheme : {"swap", "rotate"}) {
+        params.migrationScheme = scheme;
+        ReplayStats reference = expect_parallel_identical(geometry, params, requests,
+                                                          4, 2500);
+        assert(reference.scrubRows > 0 && reference.scrubEscalations > 0);
+        assert(reference.migrations > 0);
+    }
+    std::cout << "  Parallel replay identical with scrubbing, swaps and rotations ✓"
+              << std::endl;
+
+    std::cout << "Test 14: PASSED ✓\n" << std::endl;
+}
+
+void test_wear_out() {
+    std::cout << "Test 15: Wear-Out and Spare Regions" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.enduranceWrites = 3;
+    params.spareRegions = 1;
+
+    // Row 0 (fast PRN 0) fails on its third write, the region is retired
+    // at the next boundary into the slow spare
+    auto replay = [&]() {
+        std::vector<TraceRequest> requests;
+        for (uint64_t cycle : {1000, 2000, 3000}) {
+            requests.push_back(make_request(cycle, row_address(geometry, 0), TRACE_WRITE));
+        }
+        requests.push_back(make_request(4000, row_address(geometry, 0), TRACE_READ));
+        requests.push_back(make_request(150000, row_address(geometry, 0), TRACE_READ));
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+
+    ReplayStats stats = replay();
+    assert(stats.failedRows == 1 && stats.faultyAccesses == 1);
+    assert(stats.regionsRetired == 1 && stats.regionsUnrepaired == 0);
+    assert(stats.rowsMoved == 64);
+    assert(stats.fastAccesses == 4 && stats.slowAccesses == 1);
+    std::cout << "  Worn-out region moved to a spare ✓" << std::endl;
+
+    params.spareRegions = 0;
+    stats = replay();
+    assert(stats.regionsRetired == 0 && stats.regionsUnrepaired == 1);
+    assert(stats.faultyAccesses == 2 && stats.fastAccesses == 5);
+    std::cout << "  Without spares the failed rows stay in use ✓" << std::endl;
+
+    // Without spares, rotating worn-out region 5 into a fast slot leaves
+    // its failed PRN as the rotation spare: the bank swaps from then on
+    // instead of rotating live data into it
+    params.migrationScheme = "rotate";
+    auto rotations = [&](bool second) {
+        std::vector<TraceRequest> requests;
+        for (uint64_t i = 0; i < 20; i++) {
+            requests.push_back(make_request(1000 * (i + 1), row_address(geometry, 64 * 5),
+                                            i < 3 ? TRACE_WRITE : TRACE_READ));
+        }
+        for (uint64_t i = 0; second && i < 20; i++) {
+            requests.push_back(make_request(100000 + 1000 * i,
+                                            row_address(geometry, 64 * 6), TRACE_READ));
+        }
+        requests.push_back(make_request(250000, row_address(geometry, 0), TRACE_READ));
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+    ReplayStats first = rotations(false);
+    assert(first.regionsUnrepaired == 1 && first.sparesLost == 1);
+    assert(first.migrations == 1);
+    stats = rotations(true);
+    assert(stats.sparesLost == 1 && stats.migrations == 2);
+    assert(stats.migrationCycles == first.migrationCycles + params.swapCost);
+    params.migrationScheme = "swap";
+    std::cout << "  A worn-out rotation spare stops rotation in its bank ✓" << std::endl;
+
+    // Accelerated aging: every write counts three times
+    params.agingFactor = 3;
+    stats = replay();
+    assert(stats.failedRows == 1 && stats.faultyAccesses == 4);
+    std::cout << "  Aging factor wears rows out faster ✓" << std::endl;
+
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+    params.enduranceWrites = 4;
+    params.enduranceVariation = 50;
+    params.agingFactor = 1;
+    params.spareRegions = 2;
+    for (const char *scheme : {"swap", "rotate"}) {
+        params.migrationScheme = scheme;
+        ReplayStats reference = expect_parallel_identical(geometry, params, requests,
+                                                          4, 2500);
+        assert(reference.regionsRetired > 0);
+        assert(reference.regionsUnrepaired > 0);
+    }
+    std::cout << "  Parallel replay identical with wear-out ✓" << std::endl;
+
+    std::cout << "Test 15: PASSED ✓\n" << std::endl;
+}
+
+void test_ecc() {
+    std::cout << "Test 16: ECC Latency" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.eccRegions = "slow";
+    params.eccErrorPpm = 0;
+
+    auto replay = [&](uint64_t row, const std::vector<uint8_t>& ops) {
+        std::vector<TraceRequest> requests;
+        for (uint8_t op : ops) {
+            uint64_t cycle = 1000 * (requests.size() + 1);
+            requests.push_back(make_request(cycle, row_address(geometry, row), op));
+        }
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+
+    ReplayStats stats = replay(0, {TRACE_READ, TRACE_WRITE});
+    assert(stats.eccEncodes == 0 && stats.eccDecodes == 0);
+    assert(stats.totalLatency == 2 * (50 + 4));
+    stats = replay(64 * 5, {TRACE_READ, TRACE_WRITE});
+    assert(stats.eccEncodes == 1 && stats.eccDecodes == 1 && stats.eccCorrections == 0);
+    assert(stats.totalLatency == (120 + 5 + 4) + (120 + 10 + 4));
+    std::cout << "  Slow regions pay encode and decode latency ✓" << std::endl;
+
+    params.eccErrorPpm = 1000000;
+    stats = replay(64 * 5, {TRACE_READ});
+    assert(stats.eccCorrections == 1 && stats.totalLatency == 120 + 5 + 30 + 4);
+    params.eccRegions = "all";
+    params.eccErrorPpm = 0;
+    stats = replay(0, {TRACE_READ});
+    assert(stats.eccDecodes == 1 && stats.totalLatency == 50 + 5 + 4);
+    std::cout << "  Corrections and protected fast regions ✓" << std::endl;
+
+    // The worn-out write allocates a pointer, reads of the row are corrected
+    params.eccRegions = "slow";
+    params.enduranceWrites = 1;
+    stats = replay(64 * 5, {TRACE_WRITE, TRACE_READ});
+    assert(stats.eccPointerUpdates == 1 && stats.eccCorrections == 1);
+    assert(stats.totalLatency == (120 + 10 + 120 + 4) + (120 + 5 + 30 + 4));
+    std::cout << "  Failed rows need pointers and corrections ✓" << std::endl;
+
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+    params.enduranceWrites = 4;
+    params.spareRegions = 2;
+    params.eccErrorPpm = 5000;
+    params.eccWearPpm = 1000;
+    ReplayStats reference = expect_parallel_identical(geometry, params, requests, 4, 2500);
+    assert(reference.eccCorrections > 0 && reference.eccPointerUpdates > 0);
+    std::cout << "  Parallel replay identical with ECC ✓" << std::endl;
+
+    std::cout << "Test 16: PASSED ✓\n" << std::endl;
+}
+
+void test_compression() {
+    std::cout << "Test 17: Line Compression" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.compression = true;
+    params.mlcWrites = true;
+
+    // Level 3 cells need 4 pulses, the upper cells 6: a 16-byte line only
+    // programs the 8 lower cells
+    for (uint64_t entry = 0; entry < MLCParams::ENTRIES; entry++) {
+        params.mlc.iterations[0][entry] = 6;
+        params.mlc.iterations[3][entry] = 4;
+    }
+    auto replay = [&](uint8_t op, uint8_t lineBytes) {
+        std::vector<TraceRequest> requests;
+        requests.push_back(make_request(1000, row_address(geometry, 0), op));
+        requests.back().dataHash = 0xFFFF;
+        requests.back().lineBytes = lineBytes;
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+
+    ReplayStats stats = replay(TRACE_WRITE, 16);
+    assert(stats.compressedWrites == 1 && stats.lineBytesWritten == 16);
+    assert(stats.cellsWritten == 64 && stats.mlcIterations == 4);
+    assert(stats.compressionSavedCycles == 2 * 20);
+    assert(stats.totalLatency == 50 + 4 * 20 + 4);
+    stats = replay(TRACE_WRITE, 64);
+    assert(stats.compressedWrites == 0 && stats.cellsWritten == 256);
+    assert(stats.mlcIterations == 6 && stats.compressionSavedCycles == 0);
+    std::cout << "  Compressed writes program fewer cells ✓" << std::endl;
+
+    stats = replay(TRACE_READ, 16);
+    assert(stats.decompressCycles == 5 && stats.totalLatency == 50 + 5 + 4);
+    stats = replay(TRACE_READ, 0);
+    assert(stats.decompressCycles == 0);
+    params.compression = false;
+    stats = replay(TRACE_WRITE, 16);
+    assert(stats.lineBytesUncompressed == 0 && stats.mlcIterations == 6);
+    assert(stats.cellsWritten == 256);
+    std::cout << "  Reads pay decompression, unknown sizes stay raw ✓" << std::endl;
+
+    // Wear counts cells: row 0 survives three full writes, or six writes
+    // of half lines
+    params.compression = true;
+    params.enduranceWrites = 3;
+    auto writes = [&](uint8_t lineBytes, uint64_t count) {
+        std::vector<TraceRequest> requests;
+        for (uint64_t i = 0; i < count; i++) {
+            requests.push_back(make_request(1000 * (i + 1), row_address(geometry, 0),
+                                            TRACE_WRITE));
+            requests.back().lineBytes = lineBytes;
+        }
+        ReplaySerial serial(geometry, params);
+        serial.Replay(requests.data(), requests.size());
+        return serial.Stats();
+    };
+    assert(writes(64, 3).failedRows == 1);
+    assert(writes(32, 5).failedRows == 0);
+    assert(writes(32, 6).failedRows == 1);
+    params.enduranceWrites = 0;
+    std::cout << "  Compressed writes wear rows by the cells they program ✓" << std::endl;
+
+    std::vector<TraceRequest> requests = make_skewed_trace(geometry);
+    for (uint64_t i = 0; i < requests.size(); i++) {
+        requests[i].lineBytes = static_cast<uint8_t>(i % 4 == 0 ? 64 : 8 * (i % 8 + 1));
+    }
+    params.compression = true;
+    params.mlc = MLCParams();
+    ReplayStats reference = expect_parallel_identical(geometry, params, requests, 4, 2500);
+    assert(reference.compressionSavedCycles > 0);
+    std::cout << "  Parallel replay identical with compression ✓" << std::endl;
+
+    std::cout << "Test 17: PASSED ✓\n" << std::endl;
+}
+
+void test_tenant_quotas() {
+    std::cout << "Test 18: Tenant Fast-Region Quotas" << std::endl;
+
+    RegionGeometry geometry = make_geometry();
+    ReplayParams params = make_params();
+    params.tenantQuotas = {254, 2};
+
+    // Epoch 0: tenant 0 reads all but 3 fast regions of bank 0 once,
+    // tenant 1 reads slow regions 5-7 twenty times each. Epoch 1: tenant 0
+    // reads slow region 9 twenty times.
+    std::vector<TraceRequest> requests;
+    uint64_t owned = 0;
+    for (uint64_t VRN = 0; owned < 253; VRN++) {
+        if (geometry.IsFastPRN(VRN)) {
+            requests.push_back(make_request(10 * owned, row_address(geometry, 64 * VRN),
+                                            TRACE_READ));
+            owned++;
+        }
+    }
+    for (uint64_t i = 0; i < 60; i++) {
+        requests.push_back(make_request(5000 + 100 * i,
+                                        row_address(geometry, 64 * (5 + i % 3)),
+                                        TRACE_READ));
+        requests.back().requestor = 1;
+    }
+    for (uint64_t i = 0; i < 20; i++) {
+        requests.push_back(make_request(100000 + 100 * i, row_address(geometry, 64 * 9),
+                                        TRACE_READ));
+    }
+    requests.push_back(make_request(250000, row_address(geometry, 0), TRACE_READ));
+
+    auto replay = [&]() {
+        return expect_parallel_identical(geometry, params, requests, 4, requests.size());
+    };
+
+    // Tenant 1 gets two of the free fast regions, region 9 the third
+    ReplayStats stats = replay();
+    assert(stats.migrations == 3 && stats.quotaDenials == 1);
+    assert(stats.quotaBorrows == 0 && stats.quotaReclaims == 0);
+    assert(stats.tenants.size() == 2);
+    assert(stats.tenants[0].requests == 274 && stats.tenants[1].requests == 60);
+    assert(stats.tenants[0].totalLatency + stats.tenants[1].totalLatency
+           == stats.totalLatency);
+    assert(stats.tenants[1].fastRegions == 2 + 2);
+    std::cout << "  Promotions past the quota are dropped ✓" << std::endl;
+
+    // The same with tenant 1 as requestor 255 of 256 tenants
+    std::vector<uint64_t> quotas = params.tenantQuotas;
+    params.tenantQuotas.assign(256, 0);
+    params.tenantQuotas.front() = 254;
+    params.tenantQuotas.back() = 2;
+    for (TraceRequest& request : requests) {
+        request.requestor = request.requestor == 1 ? 255 : request.requestor;
+    }
+    stats = replay();
+    assert(stats.migrations == 3 && stats.quotaDenials == 1);
+    assert(stats.tenants.size() == 256 && stats.tenants[255].requests == 60);
+    assert(stats.tenants[255].fastRegions == 2 + 2);
+    for (TraceRequest& request : requests) {
+        request.requestor = request.requestor == 255 ? 1 : request.requestor;
+    }
+    params.tenantQuotas = quotas;
+    std::cout << "  Tenant 255 of 256 keeps its quota ✓" << std::endl;
+
+    // Tenant 1 borrows the third, tenant 0 takes it back for region 9
+    // instead of giving up one of its own
+    params.tenantBorrowing = true;
+    stats = replay();
+    assert(stats.migrations == 4 && stats.quotaDenials == 0);
+    assert(stats.quotaBorrows == 1 && stats.quotaReclaims == 1);
+    assert(stats.tenants[1].fastRegions == 3 + 2);
+    assert(stats.tenants[0].fastRegions == 253 + 254);
+    std::cout << "  Idle quota is borrowed and reclaimed ✓" << std::endl;
+
+    // Once tenant 0 holds all fast regions within its quota, tenant 1
+    // gets none of them; region 9 still replaces one of tenant 0's own
+    params.tenantQuotas = {256, 2};
+    for (uint64_t VRN = 0, fast = 0; VRN < 1024; VRN++) {
+        if (geometry.IsFastPRN(VRN) && fast++ >= 253) {
+            requests.push_back(make_request(3000 + VRN, row_address(geometry, 64 * VRN),
+                                            TRACE_READ));
+        }
+    }
+    std::sort(requests.begin(), requests.end(),
+              [](const TraceRequest& a, const TraceRequest& b) {
+                  return a.cycle < b.cycle;
+              });
+    stats = replay();
+    assert(stats.migrations == 1 && stats.quotaDenials == 3);
+    assert(stats.tenants[1].fastRegions == 0);
+    std::cout << "  Regions within a quota are never demoted for another tenant ✓"
+              << std::endl;
+
+    std::vector<TraceRequest> trace = make_skewed_trace(geometry);
+    for (uint64_t i = 0; i < trace.size(); i++) {
+        trace[i].requestor = static_cast<uint16_t>(i % 5);
+    }
+    params.tenantQuotas = {64, 32, 16};
+    for (bool borrowing : {false, true}) {
+        params.tenantBorrowing = borrowing;
+        ReplayStats reference = expect_parallel_identical(geometry, params, trace, 4, 2500);
+        assert(reference.migrations > 0);
+        assert(reference.tenants[2].requests == 3 * trace.size() / 5);
+        assert(borrowing ? reference.quotaBorrows > 0 : reference.quotaDenials > 0);
+    }
+    std::cout << "  Parallel replay identical with quotas ✓" << std::endl;
+
+    std::cout << "Test 18: PASSED ✓\n" << std::endl;
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "Trace Replay Engine Unit Tests" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+
+    test_single_request();
+    test_bank_and_bus();
+    test_queue_full();
+    test_parallel_identical();
+    test_mapping_cache();
+    test_rotate_migration();
+    test_in_bank_copy();
+    test_migration_budget();
+    test_decision_latency();
+    test_mapping_snapshots();
+    test_mat_parallelism();
+    test_row_buffer();
+    test_mlc_writes();
+    test_scrubbing();
+    test_wear_out();
+    test_ecc();
+    test_compression();
+    test_tenant_quotas();
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ALL TESTS PASSED ✓✓✓" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * Unit Test: Per-Tenant Fast-Region Quotas
+ *
+ * This test verifies that tools/tenant_quota.h:
+ * 1. Maps requestors to tenants, the last tenant taking the rest
+ * 2. Counts the fast regions each tenant holds
+ * 3. Drops promotions past a quota, or counts them as borrows
+ * 4. Never demotes another tenant's region within its quota
+ * 5. Takes borrowed regions back for a tenant below its quota
+ */
+
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "../tools/tenant_quota.h"
+
+struct Swap {
+    uint64_t hotVRN;
+    uint64_t coldVRN;
+};
+
+// 8 regions, the first 4 of them fast
+const std::vector<uint8_t> FAST = {1, 1, 1, 1, 0, 0, 0, 0};
+
+void test_requestor_tenant() {
+    std::cout << "Test 1: Requestor to Tenant" << std::endl;
+
+    assert(RequestorTenant(3, 0) == 0);
+    assert(RequestorTenant(3, 2) == 2);
+    assert(RequestorTenant(3, 7) == 2);
+    assert(RequestorTenant(1, 65535) == 0);
+    std::cout << "  Requestors past the last quota share the last tenant ✓" << std::endl;
+
+    std::cout << "Test 1: PASSED ✓\n" << std::endl;
+}
+
+void test_count_held() {
+    std::cout << "Test 2: Fast Regions Held" << std::endl;
+
+    TenantQuotas quotas({2, 2}, false, FAST.size());
+    assert(quotas.Tenants() == 2);
+    assert(quotas.Owner(0) == TenantQuotas::NO_TENANT);
+    quotas.Access(0, 0);
+    quotas.Access(1, 1);
+    quotas.Access(1, 0);
+    quotas.Access(2, 1);
+    quotas.Access(5, 1);
+    std::vector<uint64_t> held = quotas.CountHeld(FAST);
+    assert(held.size() == 2 && held[0] == 2 && held[1] == 1);
+    std::cout << "  Last accessor owns the region, slow regions not held ✓" << std::endl;
+
+    std::cout << "Test 2: PASSED ✓\n" << std::endl;
+}
+
+void test_quota_denial() {
+    std::cout << "Test 3: Promotions Past the Quota" << std::endl;
+
+    std::vector<double> score = {3, 2, 1, 0.5, 9, 0, 0, 0};
+    for (bool borrowing : {false, true}) {
+        TenantQuotas quotas({2, 2}, borrowing, FAST.size());
+        quotas.Access(0, 0);
+        quotas.Access(1, 0);
+        quotas.Access(2, 1);
+        quotas.Access(4, 0);
+
+        // Tenant 0 holds 2 of 2: promoting region 4 into the free slot 3
+        std::vector<Swap> swaps = {{4, 3}};
+        quotas.Filter(swaps, FAST, score);
+        if (borrowing) {
+            assert(swaps.size() == 1 && quotas.borrows == 1 && quotas.denials == 0);
+        } else {
+            assert(swaps.empty() && quotas.denials == 1 && quotas.borrows == 0);
+        }
+    }
+    std::cout << "  Dropped, or borrowed with borrowing on ✓" << std::endl;
+
+    std::cout << "Test 3: PASSED ✓\n" << std::endl;
+}
+
+void test_protected_regions() {
+    std::cout << "Test 4: Regions Within a Quota Stay Fast" << std::endl;
+
+    std::vector<double> score = {1, 2, 3, 0.5, 0, 5, 0, 0};
+    TenantQuotas quotas({2, 2}, false, FAST.size());
+    quotas.Access(0, 0);
+    quotas.Access(1, 0);
+    quotas.Access(2, 1);
+    quotas.Access(5, 1);
+
+    // Tenant 1 may not take region 0 of tenant 0, the unowned slot 3 is
+    // demoted in its place
+    std::vector<Swap> swaps = {{5, 0}};
+    quotas.Filter(swaps, FAST, score);
+    assert(swaps.size() == 1 && swaps[0].hotVRN == 5 && swaps[0].coldVRN == 3);
+    assert(quotas.denials == 0);
+    std::cout << "  Redirected to the coldest unowned fast region ✓" << std::endl;
+
+    // Without a colder region to demote the swap is dropped
+    score[3] = 10;
+    swaps = {{5, 0}};
+    quotas.Filter(swaps, FAST, score);
+    assert(swaps.empty() && quotas.denials == 1);
+    std::cout << "  Dropped if no colder region may be demoted ✓" << std::endl;
+
+    std::cout << "Test 4: PASSED ✓\n" << std::endl;
+}
+
+void test_reclaim() {
+    std::cout << "Test 5: Borrowed Regions Taken Back" << std::endl;
+
+    // Tenant 0 borrowed a third fast region, tenant 1 holds one of 2
+    std::vector<double> score = {3, 1, 2, 4, 0, 0, 9, 0};
+    TenantQuotas quotas({2, 2}, true, FAST.size());
+    quotas.Access(0, 0);
+    quotas.Access(1, 0);
+    quotas.Access(2, 0);
+    quotas.Access(3, 1);
+    quotas.Access(6, 1);
+
+    // The policy demotes tenant 1's own region 3; tenant 0's coldest
+    // region goes instead
+    std::vector<Swap> swaps = {{6, 3}};
+    quotas.Filter(swaps, FAST, score);
+    assert(swaps.size() == 1 && swaps[0].coldVRN == 1);
+    assert(quotas.reclaims == 1 && quotas.borrows == 0 && quotas.denials == 0);
+    std::cout << "  Tenant below its quota reclaims the borrowed region ✓" << std::endl;
+
+    std::cout << "Test 5: PASSED ✓\n" << std::endl;
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "Tenant Quota Unit Tests" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+
+    test_requestor_tenant();
+    test_count_held();
+    test_quota_denial();
+    test_protected_regions();
+    test_reclaim();
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ALL TESTS PASSED ✓✓✓" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+/**
+ * Unit Test: Binary Trace Format
+ *
+ * This test verifies that the binary request trace in tools/trace_format.h:
+ * 1. Round-trips varint and zigzag encoding
+ * 2. Decodes a chunk back to the encoded requests, with and without data
+ *    hashes and compressed line sizes, and rejects a truncated payload
+ *    without reading past its end
+ * 3. Passes requests through the SPSC ring in order across threads
+ * 4. Writes a file whose index locates every chunk (random seek), with a
+ *    header readers reject for unknown versions and flags, and reports
+ *    failed writes
+ */
+
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../tools/trace_format.h"
+
+TraceRequest make_request(uint64_t i) {
+    TraceRequest request;
+    request.cycle = i * 7 + (i % 3);
+    request.address = (i * 0x9E3779B97F4A7C15ULL) & 0xFFFFFFFC0ULL;
+    request.dataHash = i * 31 + 1;
+    request.size = (i % 10 == 0) ? 32 : 64;
+    request.requestor = static_cast<uint16_t>(i % 4);
+    request.op = (i % 3 == 0) ? TRACE_WRITE : TRACE_READ;
+    request.lineBytes = static_cast<uint8_t>(i % 65);
+    return request;
+}
+
+bool same_request(const TraceRequest& a, const TraceRequest& b, bool dataHash,
+                  bool lineBytes = false) {
+    return a.cycle == b.cycle && a.address == b.address && a.size == b.size
+        && a.requestor == b.requestor && a.op == b.op
+        && (!dataHash || a.dataHash == b.dataHash)
+        && (!lineBytes || a.lineBytes == b.lineBytes);
+}
+
+// Decode the first payloadBytes of payload placed right before an
+// inaccessible page, so any read past them faults
+bool decode_guarded(const std::vector<uint8_t>& payload, uint32_t payloadBytes,
+                    uint32_t numRecords, bool dataHash, bool lineBytes) {
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t pages = (payloadBytes + page - 1) / page + 1;
+    void *mapping = ::mmap(nullptr, pages * page, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(mapping != MAP_FAILED);
+    uint8_t *guard = static_cast<uint8_t *>(mapping) + (pages - 1) * page;
+    assert(::mprotect(guard, page, PROT_NONE) == 0);
+    std::memcpy(guard - payloadBytes, payload.data(), payloadBytes);
+
+    ChunkHeader header;
+    header.numRecords = numRecords;
+    header.payloadBytes = payloadBytes;
+    std::vector<TraceRequest> decoded(numRecords);
+    bool valid = DecodeChunk(guard - payloadBytes, header, dataHash, decoded.data(),
+                             lineBytes);
+    ::munmap(mapping, pages * page);
+    return valid;
+}
+
+void test_varint() {
+    std::cout << "Test 1: Varint and ZigZag Encoding" << std::endl;
+
+    const uint64_t values[] = {0, 1, 127, 128, 300, 1ULL << 35, ~0ULL};
+    std::vector<uint8_t> buffer;
+    for (uint64_t value : values) {
+        PutVarint(buffer, value);
+    }
+
+    const uint8_t *in = buffer.data();
+    const uint8_t *end = buffer.data() + buffer.size();
+    for (uint64_t value : values) {
+        uint64_t decoded;
+        in = GetVarint(in, end, decoded);
+        assert(decoded == value);
+    }
+    assert(in == end);
+    std::cout << "  Varints round-trip, 0..2^64-1 ✓" << std::endl;
+
+    uint64_t decoded;
+    assert(GetVarint(buffer.data(), buffer.data(), decoded) == nullptr);
+    assert(GetVarint(end - 10, end - 1, decoded) == nullptr);
+    std::cout << "  Varint cut short by the end rejected ✓" << std::endl;
+
+    const int64_t deltas[] = {0, -1, 1, -64, 64, INT64_MIN, INT64_MAX};
+    for (int64_t delta : deltas) {
+        assert(UnZigZag(ZigZag(delta)) == delta);
+    }
+    assert(ZigZag(-1) == 1 && ZigZag(1) == 2);
+    std::cout << "  Small negative deltas stay small ✓" << std::endl;
+
+    std::cout << "Test 1: PASSED ✓\n" << std::endl;
+}
+
+void test_chunk_roundtrip() {
+    std::cout << "Test 2: Chunk Encode/Decode" << std::endl;
+
+    for (int dataHash = 0; dataHash < 2; dataHash++) {
+        ChunkEncoder encoder(dataHash != 0);
+        std::vector<TraceRequest> requests;
+        for (uint64_t i = 0; i < 1000; i++) {
+            requests.push_back(make_request(i));
+            encoder.Add(requests.back());
+        }
+
+        ChunkHeader header;
+        header.numRecords = encoder.numRecords;
+        header.payloadBytes = static_cast<uint32_t>(encoder.payload.size());
+
+        std::vector<TraceRequest> decoded(header.numRecords);
+        assert(DecodeChunk(encoder.payload.data(), header, dataHash != 0, decoded.data()));
+        for (uint64_t i = 0; i < requests.size(); i++) {
+            assert(same_request(requests[i], decoded[i], dataHash != 0));
+        }
+        assert(encoder.firstTick == requests.front().cycle);
+        assert(encoder.lastTick == requests.back().cycle);
+
+        header.payloadBytes /= 2;
+        assert(!DecodeChunk(encoder.payload.data(), header, dataHash != 0, decoded.data()));
+
+        std::cout << "  " << (dataHash ? "With" : "Without") << " data hashes: "
+                  << encoder.payload.size() / 1000.0 << " bytes/record ✓" << std::endl;
+    }
+
+    ChunkEncoder encoder(false, true);
+    std::vector<TraceRequest> requests;
+    for (uint64_t i = 0; i < 1000; i++) {
+        requests.push_back(make_request(i));
+        encoder.Add(requests.back());
+    }
+    ChunkHeader header;
+    header.numRecords = encoder.numRecords;
+    header.payloadBytes = static_cast<uint32_t>(encoder.payload.size());
+    std::vector<TraceRequest> decoded(header.numRecords);
+    assert(DecodeChunk(encoder.payload.data(), header, false, decoded.data(), true));
+    for (uint64_t i = 0; i < requests.size(); i++) {
+        assert(same_request(requests[i], decoded[i], false, true));
+    }
+    std::cout << "  With compressed line sizes ✓" << std::endl;
+
+    // Cut the payload at every byte, inside varints, data hashes and line sizes
+    for (int dataHash = 0; dataHash < 2; dataHash++) {
+        ChunkEncoder truncated(dataHash != 0, true);
+        for (uint64_t i = 0; i < 20; i++) {
+            truncated.Add(make_request(i));
+        }
+        const std::vector<uint8_t>& payload = truncated.payload;
+        const uint32_t payloadBytes = static_cast<uint32_t>(payload.size());
+        assert(decode_guarded(payload, payloadBytes, truncated.numRecords,
+                              dataHash != 0, true));
+        for (uint32_t cut = 0; cut < payloadBytes; cut++) {
+            assert(!decode_guarded(payload, cut, truncated.numRecords, dataHash != 0, true));
+        }
+    }
+    std::cout << "  Truncated payload rejected ✓" << std::endl;
+
+    std::cout << "Test 2: PASSED ✓\n" << std::endl;
+}
+
+void test_spsc_ring() {
+    std::cout << "Test 3: SPSC Ring Ordering" << std::endl;
+
+    const uint64_t count = 1000000;
+    SPSCRing<uint64_t> ring(1000);
+    bool ordered = true;
+
+    std::thread consumer([&]() {
+        uint64_t expected = 0, value;
+        while (expected < count) {
+            if (ring.TryPop(value)) {
+                ordered = ordered && (value == expected);
+                expected++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t fullPushes = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        while (!ring.TryPush(i)) {
+            fullPushes++;
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+
+    assert(ordered);
+    uint64_t value;
+    assert(!ring.TryPop(value));
+    std::cout << "  " << count << " values received in order ✓" << std::endl;
+    std::cout << "  Full ring rejected " << fullPushes << " pushes, none lost ✓"
+              << std::endl;
+
+    std::cout << "Test 3: PASSED ✓\n" << std::endl;
+}
+
+void test_file_index() {
+    std::cout << "Test 4: Trace File and Index" << std::endl;
+
+    const char *path = "/tmp/test_trace_format.nvmt";
+    const uint64_t count = 10000;
+    const uint32_t chunkRecords = 1024;
+
+    TraceWriter writer;
+    assert(writer.Open(path, true, chunkRecords));
+    for (uint64_t i = 0; i < count; i++) {
+        writer.Record(make_request(i));
+    }
+    assert(writer.Close());
+
+    std::FILE *file = std::fopen(path, "rb");
+    assert(file);
+
+    FileHeader header;
+    assert(std::fread(&header, sizeof(header), 1, file) == 1);
+    assert(std::memcmp(header.magic, TRACE_MAGIC, 8) == 0);
+    assert(header.flags & FILE_DATA_HASH);
+
+    FileFooter footer;
+    std::fseek(file, -static_cast<long>(sizeof(footer)), SEEK_END);
+    assert(std::fread(&footer, sizeof(footer), 1, file) == 1);
+    assert(std::memcmp(footer.magic, TRACE_INDEX_MAGIC, 8) == 0);
+    assert(footer.numRecords == count);
+    assert(footer.numChunks == (count + chunkRecords - 1) / chunkRecords);
+    std::cout << "  " << footer.numChunks << " chunks, " << footer.numRecords
+              << " records ✓" << std::endl;
+
+    std::vector<IndexEntry> index(footer.numChunks);
+    std::fseek(file, static_cast<long>(footer.indexOffset), SEEK_SET);
+    assert(std::fread(index.data(), sizeof(IndexEntry), index.size(), file)
+           == index.size());
+
+    // Seek straight to each chunk, last one first
+    std::vector<TraceRequest> decoded;
+    for (uint64_t c = index.size(); c-- > 0;) {
+        std::fseek(file, static_cast<long>(index[c].offset), SEEK_SET);
+        ChunkHeader chunk;
+        assert(std::fread(&chunk, sizeof(chunk), 1, file) == 1);
+        std::vector<uint8_t> payload(chunk.payloadBytes);
+        assert(std::fread(payload.data(), 1, payload.size(), file) == payload.size());
+
+        decoded.resize(chunk.numRecords);
+        assert(DecodeChunk(payload.data(), chunk, true, decoded.data()));
+        for (uint32_t i = 0; i < chunk.numRecords; i++) {
+            assert(same_request(decoded[i], make_request(index[c].firstRecord + i), true));
+        }
+        assert(index[c].firstTick == decoded.front().cycle);
+        assert(index[c].lastTick == decoded.back().cycle);
+    }
+    std::fclose(file);
+    std::remove(path);
+    std::cout << "  Every chunk decoded after a random seek ✓" << std::endl;
+
+    // Version 1 files have no line bytes, unknown flags change the layout
+    assert(header.version == TRACE_VERSION && SupportedHeader(header));
+    header.version = 1;
+    assert(SupportedHeader(header));
+    header.flags |= FILE_LINE_BYTES;
+    assert(!SupportedHeader(header));
+    header.version = 2;
+    assert(SupportedHeader(header));
+    header.flags |= 1 << 7;
+    assert(!SupportedHeader(header));
+    header.flags = 0;
+    header.version = TRACE_VERSION + 1;
+    assert(!SupportedHeader(header));
+    std::cout << "  Unknown versions and flags rejected ✓" << std::endl;
+
+    // A device that takes no data fails the close, not silently
+    TraceWriter full;
+    if (full.Open("/dev/full", true, chunkRecords)) {
+        for (uint64_t i = 0; i < count; i++) {
+            full.Record(make_request(i));
+        }
+        assert(!full.Close());
+        std::cout << "  Failed writes reported by Close ✓" << std::endl;
+    }
+    assert(!full.Close());
+
+    std::cout << "Test 4: PASSED ✓\n" << std::endl;
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "Binary Trace Format Unit Tests" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+
+    test_varint();
+    test_chunk_roundtrip();
+    test_spsc_ring();
+    test_file_index();
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ALL TESTS PASSED ✓✓✓" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return 0;
+}
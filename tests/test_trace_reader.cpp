@@ -0,0 +1,303 @@
+/**
+ * Unit Test: Memory-Mapped Trace Reader
+ *
+ * This test verifies that tools/trace_reader.h:
+ * 1. Delivers every request of a binary trace in order, for any number of
+ *    decode threads and buffers
+ * 2. Seeks to the chunk holding a tick or record
+ * 3. Reports a corrupt chunk instead of returning bad requests
+ * 4. Rejects files that are not complete binary traces, and reports the
+ *    ones that start like a binary trace as corrupt
+ * 5. Rejects an index that does not fit the file or orders its chunks
+ *    wrongly, and a chunk whose payload runs into the index
+ */
+
+#include <iostream>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "../tools/trace_reader.h"
+
+const char *TRACE_PATH = "/tmp/test_trace_reader.nvmt";
+const uint64_t NUM_REQUESTS = 50000;
+
+TraceRequest make_request(uint64_t i) {
+    TraceRequest request;
+    request.cycle = i * 5;
+    request.address = (i * 2654435761ULL) << 6;
+    request.dataHash = 0;
+    request.size = 64;
+    request.requestor = static_cast<uint16_t>(i % 2);
+    request.op = (i % 4 == 0) ? TRACE_WRITE : TRACE_READ;
+    request.lineBytes = 0;
+    return request;
+}
+
+void write_trace() {
+    TraceWriter writer;
+    assert(writer.Open(TRACE_PATH, false, 1000));
+    for (uint64_t i = 0; i < NUM_REQUESTS; i++) {
+        writer.Record(make_request(i));
+    }
+    assert(writer.Close());
+}
+
+// Copy the test trace to path, with modify applied to its bytes
+void write_modified(const char *path, const std::function<void(std::vector<char>&)>& modify) {
+    std::ifstream in(TRACE_PATH, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    modify(data);
+    std::ofstream out(path, std::ios::binary);
+    out.write(data.data(), data.size());
+}
+
+// Read the whole trace and check every request against make_request
+uint64_t read_and_check(TraceReader& reader, uint64_t first) {
+    TraceBlock block;
+    uint64_t expected = first;
+    while (reader.Next(block)) {
+        assert(block.firstRecord == expected);
+        for (uint64_t i = 0; i < block.count; i++) {
+            TraceRequest request = make_request(expected + i);
+            assert(block.requests[i].cycle == request.cycle);
+            assert(block.requests[i].address == request.address);
+            assert(block.requests[i].op == request.op);
+            assert(block.requests[i].requestor == request.requestor);
+        }
+        expected += block.count;
+    }
+    assert(!reader.Failed());
+    return expected;
+}
+
+void test_ordered_delivery() {
+    std::cout << "Test 1: Ordered Parallel Decode" << std::endl;
+
+    TraceReader reader;
+    assert(reader.Open(TRACE_PATH));
+    assert(reader.NumRecords() == NUM_REQUESTS);
+    assert(reader.NumChunks() == 50);
+
+    const uint64_t configs[][2] = {{1, 1}, {1, 0}, {4, 0}, {8, 3}};
+    for (const auto& config : configs) {
+        reader.Start(config[0], 0, config[1]);
+        assert(read_and_check(reader, 0) == NUM_REQUESTS);
+        std::cout << "  " << config[0] << " threads, " << reader.Buffers()
+                  << " buffers: all " << NUM_REQUESTS << " requests in order ✓"
+                  << std::endl;
+    }
+
+    // Stopping mid-trace must not hang
+    reader.Start(4);
+    TraceBlock block;
+    assert(reader.Next(block));
+    reader.Stop();
+    std::cout << "  Stop before the end of the trace ✓" << std::endl;
+
+    std::cout << "Test 1: PASSED ✓\n" << std::endl;
+}
+
+void test_seek() {
+    std::cout << "Test 2: Random Seek" << std::endl;
+
+    TraceReader reader;
+    assert(reader.Open(TRACE_PATH));
+
+    // Chunk 17 holds requests 17000..17999, ticks 85000..89995
+    assert(reader.ChunkForRecord(17000) == 17);
+    assert(reader.ChunkForRecord(17999) == 17);
+    assert(reader.ChunkForTick(85000) == 17);
+    assert(reader.ChunkForTick(89996) == 18);
+    assert(reader.ChunkForTick(~0ULL) == reader.NumChunks());
+    std::cout << "  Record and tick lookups ✓" << std::endl;
+
+    reader.Start(2, 17);
+    assert(read_and_check(reader, 17000) == NUM_REQUESTS);
+    std::cout << "  Replay from chunk 17 ✓" << std::endl;
+
+    std::cout << "Test 2: PASSED ✓\n" << std::endl;
+}
+
+void test_corrupt_chunk() {
+    std::cout << "Test 3: Corrupt Chunk" << std::endl;
+
+    // Claim chunk 0 holds more records than its index entry
+    const char *path = "/tmp/test_trace_reader_corrupt.nvmt";
+    write_modified(path, [](std::vector<char>& data) {
+        ChunkHeader header;
+        std::memcpy(&header, data.data() + sizeof(FileHeader), sizeof(header));
+        header.numRecords++;
+        std::memcpy(data.data() + sizeof(FileHeader), &header, sizeof(header));
+    });
+
+    TraceReader reader;
+    assert(reader.Open(path));
+    reader.Start(2);
+    TraceBlock block;
+    assert(!reader.Next(block));
+    assert(reader.Failed());
+    std::remove(path);
+    std::cout << "  Corrupt chunk reported ✓" << std::endl;
+
+    std::cout << "Test 3: PASSED ✓\n" << std::endl;
+}
+
+void test_invalid_files() {
+    std::cout << "Test 4: Invalid Files" << std::endl;
+
+    TraceReader reader;
+    assert(!reader.Open("/tmp/does_not_exist.nvmt"));
+
+    const char *path = "/tmp/test_trace_reader.nvt";
+    {
+        std::ofstream out(path);
+        out << "NVMV1" << std::endl;
+        out << "10 R 0x1000 0 0" << std::endl;
+        out << "20 W 0x2000 ff 0 1" << std::endl;
+    }
+    assert(!reader.Open(path));
+    std::cout << "  Missing and text traces rejected ✓" << std::endl;
+
+    // TraceSource falls back to the text parser
+    TraceSource source;
+    assert(source.Open(path, 2) && !source.IsBinary());
+    TraceBlock block;
+    assert(source.Next(block) && block.count == 2);
+    assert(block.requests[1].op == TRACE_WRITE && block.requests[1].address == 0x2000);
+    assert(!source.Next(block));
+    std::remove(path);
+    std::cout << "  TraceSource reads text traces ✓" << std::endl;
+
+    // A truncated binary trace is corrupt, not a text trace
+    path = "/tmp/test_trace_reader_truncated.nvmt";
+    {
+        std::ifstream in(TRACE_PATH, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+        std::ofstream out(path, std::ios::binary);
+        out.write(data.data(), data.size() / 2);
+    }
+    TraceSource truncated;
+    assert(!truncated.Open(path, 2) && truncated.Failed());
+    std::remove(path);
+    std::cout << "  TraceSource reports truncated binary traces ✓" << std::endl;
+
+    std::cout << "Test 4: PASSED ✓\n" << std::endl;
+}
+
+void test_corrupt_index() {
+    std::cout << "Test 5: Corrupt Index" << std::endl;
+
+    const char *path = "/tmp/test_trace_reader_index.nvmt";
+    FileFooter footer;
+    {
+        std::ifstream in(TRACE_PATH, std::ios::binary);
+        in.seekg(-static_cast<std::streamoff>(sizeof(footer)), std::ios::end);
+        in.read(reinterpret_cast<char *>(&footer), sizeof(footer));
+    }
+    auto footerAt = [](std::vector<char>& data) {
+        return data.data() + data.size() - sizeof(FileFooter);
+    };
+    auto entryAt = [&](std::vector<char>& data, uint64_t chunk) {
+        return data.data() + footer.indexOffset + chunk * sizeof(IndexEntry);
+    };
+    auto corrupt = [&]() {
+        TraceReader reader;
+        TraceSource source;
+        bool rejected = !reader.Open(path) && !source.Open(path, 2) && source.Failed();
+        std::remove(path);
+        return rejected;
+    };
+
+    // A chunk count whose index would not fit, or whose index size wraps
+    // around to the real one
+    const uint64_t wrap = 1ULL << 59;
+    for (uint64_t numChunks : {footer.numChunks + 1, wrap, footer.numChunks + wrap}) {
+        write_modified(path, [&](std::vector<char>& data) {
+            FileFooter modified = footer;
+            modified.numChunks = numChunks;
+            std::memcpy(footerAt(data), &modified, sizeof(modified));
+        });
+        assert(corrupt());
+    }
+    std::cout << "  Chunk count larger than the file rejected ✓" << std::endl;
+
+    // Chunk 2 repeats the first record of chunk 1, the last chunk starts
+    // past the end of the trace
+    write_modified(path, [&](std::vector<char>& data) {
+        IndexEntry entry;
+        std::memcpy(&entry, entryAt(data, 1), sizeof(entry));
+        std::memcpy(entryAt(data, 2) + offsetof(IndexEntry, firstRecord),
+                    &entry.firstRecord, sizeof(entry.firstRecord));
+    });
+    assert(corrupt());
+    write_modified(path, [&](std::vector<char>& data) {
+        uint64_t firstRecord = footer.numRecords;
+        std::memcpy(entryAt(data, footer.numChunks - 1) + offsetof(IndexEntry, firstRecord),
+                    &firstRecord, sizeof(firstRecord));
+    });
+    assert(corrupt());
+    std::cout << "  Non-increasing chunk records rejected ✓" << std::endl;
+
+    // A chunk header inside the index
+    write_modified(path, [&](std::vector<char>& data) {
+        uint64_t offset = footer.indexOffset;
+        std::memcpy(entryAt(data, 0) + offsetof(IndexEntry, offset), &offset, sizeof(offset));
+    });
+    assert(corrupt());
+    std::cout << "  Chunk offset past the chunk data rejected ✓" << std::endl;
+
+    // The last payload runs into the index but not past the end of the file
+    write_modified(path, [&](std::vector<char>& data) {
+        IndexEntry entry;
+        std::memcpy(&entry, entryAt(data, footer.numChunks - 1), sizeof(entry));
+        ChunkHeader header;
+        std::memcpy(&header, data.data() + entry.offset, sizeof(header));
+        header.payloadBytes += sizeof(IndexEntry);
+        std::memcpy(data.data() + entry.offset, &header, sizeof(header));
+    });
+    TraceReader reader;
+    assert(reader.Open(path));
+    reader.Start(2);
+    TraceBlock block;
+    uint64_t blocks = 0;
+    while (reader.Next(block)) {
+        blocks++;
+    }
+    assert(reader.Failed() && blocks < footer.numChunks);
+    reader.Close();
+    std::remove(path);
+    std::cout << "  Payload running into the index reported ✓" << std::endl;
+
+    std::cout << "Test 5: PASSED ✓\n" << std::endl;
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "Trace Reader Unit Tests" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+
+    write_trace();
+
+    test_ordered_delivery();
+    test_seek();
+    test_corrupt_chunk();
+    test_invalid_files();
+    test_corrupt_index();
+
+    std::remove(TRACE_PATH);
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ALL TESTS PASSED ✓✓✓" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,694 @@
+/**
+ * Analytical Estimator for Dynamic ReRAM Region Mapping
+ *
+ * Estimates, without timing simulation, what the Alpha/Beta/MigrationThreshold
+ * heuristic of ReRAMRegionController achieves for many parameter sets:
+ *   fast region hit rate   - accesses served by fast regions
+ *   average latency        - FastRegionLatency / SlowRegionLatency weighted
+ *                            by the hit rate
+ *   migration volume       - swaps and rows moved (2 * RegionSize per swap)
+ *
+ * The trace is read once and reduced to per-epoch region access histograms
+ * (one sparse histogram per bank and epoch, one set per EpochLength). Each
+ * parameter set is then evaluated on the histograms only: accesses of an
+ * epoch hit fast regions according to the placement at the start of the
+ * epoch, and at the end of the epoch the heuristic swaps regions exactly
+ * like ThresholdPolicy in tools/migration_policy.h. Only regions with a
+ * non-zero score are touched, and the idle fast regions that are swapped
+ * out first are found in a per-bank bitmap, so the cost of one parameter
+ * set is proportional to the number of active regions, not to capacity.
+ * Parameter sets are spread over all host cores.
+ *
+ * The result matches the epoch-level replay of tools/oracle_placement
+ * (online column with --policy threshold). --stats compares the parameter
+ * set of the configuration file against a full gem5/NVMain run, using the
+ * last statistics dump of the file or the one --stats-dump selects.
+ *
+ * Usage:
+ *   analytical_estimator --config <nvmain.config> --trace <trace.nvt|trace.nvmt>
+ *                        [--alpha a,b,..] [--beta a,b,..]
+ *                        [--epoch-length a,b,..] [--threshold a,b,..]
+ *                        [--decay a,b,..] [--threads N] [--top N]
+ *                        [--csv <file>] [--stats <stats.txt>] [--stats-dump N]
+ *                        [--order R:RK:BK:CH:C]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "region_geometry.h"
+#include "trace_reader.h"
+#include "trace_request.h"
+
+// Scores below this are treated as zero once they decay
+static const double MIN_SCORE = 1e-9;
+
+/*
+ * Sparse per-epoch access histograms for one EpochLength. Entries of
+ * epoch e and bank b are [offsets[e * numBanks + b], offsets[... + 1]),
+ * sorted by VRN.
+ */
+struct EpochHistograms {
+    uint64_t epochLength = 0;
+    uint64_t numEpochs = 0;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> VRN;
+    std::vector<uint32_t> reads;
+    std::vector<uint32_t> writes;
+};
+
+struct EstimatorConfig {
+    double alpha;
+    double beta;
+    uint64_t epochLength;
+    double threshold;
+    double decay;
+};
+
+struct Estimate {
+    uint64_t fastAccesses = 0;
+    uint64_t slowAccesses = 0;
+    uint64_t swaps = 0;
+};
+
+class HistogramBuilder {
+public:
+    HistogramBuilder(uint64_t epochLength, uint64_t numBanks)
+        : numBanks(numBanks) {
+        histograms.epochLength = epochLength;
+        histograms.offsets.push_back(0);
+    }
+
+    void Add(uint64_t cycle, uint64_t bank, uint64_t VRN, uint8_t op) {
+        uint64_t epoch = cycle / histograms.epochLength;
+        // Out of order requests are folded into the current epoch
+        while (epoch > currentEpoch) {
+            Flush();
+        }
+
+        Counts& counts = current[bank << 32 | VRN];
+        if (op == TRACE_WRITE) {
+            counts.writes++;
+        } else {
+            counts.reads++;
+        }
+    }
+
+    EpochHistograms& Finish() {
+        Flush();
+        return histograms;
+    }
+
+private:
+    struct Counts {
+        uint32_t reads = 0;
+        uint32_t writes = 0;
+    };
+
+    void Flush() {
+        std::vector<uint64_t> keys;
+        keys.reserve(current.size());
+        for (const auto& entry : current) {
+            keys.push_back(entry.first);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        size_t next = 0;
+        for (uint64_t bank = 0; bank < numBanks; bank++) {
+            while (next < keys.size() && (keys[next] >> 32) == bank) {
+                const Counts& counts = current[keys[next]];
+                histograms.VRN.push_back(static_cast<uint32_t>(keys[next]));
+                histograms.reads.push_back(counts.reads);
+                histograms.writes.push_back(counts.writes);
+                next++;
+            }
+            histograms.offsets.push_back(histograms.VRN.size());
+        }
+
+        current.clear();
+        histograms.numEpochs++;
+        currentEpoch++;
+    }
+
+    uint64_t numBanks;
+    uint64_t currentEpoch = 0;
+    std::unordered_map<uint64_t, Counts> current;
+    EpochHistograms histograms;
+};
+
+/*
+ * Replays the heuristic for one parameter set on the histograms. One
+ * instance is reused for many parameter sets by one thread.
+ */
+class Evaluator {
+public:
+    explicit Evaluator(const RegionGeometry& geometry)
+        : geometry(geometry),
+          numBanks(geometry.NumBanks()),
+          numRegions(geometry.RegionsPerBank()),
+          numWords((numRegions + 63) / 64) {
+        identityFast.assign(numWords, 0);
+        for (uint64_t VRN = 0; VRN < numRegions; VRN++) {
+            if (geometry.IsFastPRN(VRN)) {
+                identityFast[VRN / 64] |= 1ULL << (VRN % 64);
+            }
+        }
+        banks.resize(numBanks);
+    }
+
+    Estimate Evaluate(const EstimatorConfig& config,
+                      const EpochHistograms& histograms) {
+        Estimate estimate;
+
+        for (BankState& bank : banks) {
+            bank.fast = identityFast;
+            bank.score.assign(numRegions, 0.0);
+            bank.activeMask.assign(numWords, 0);
+            bank.active.clear();
+        }
+
+        for (uint64_t epoch = 0; epoch < histograms.numEpochs; epoch++) {
+            for (uint64_t b = 0; b < numBanks; b++) {
+                uint64_t begin = histograms.offsets[epoch * numBanks + b];
+                uint64_t end = histograms.offsets[epoch * numBanks + b + 1];
+                BankState& bank = banks[b];
+
+                if (begin == end && bank.active.empty()) {
+                    continue;
+                }
+
+                Count(bank, histograms, begin, end, estimate);
+                Score(bank, config, histograms, begin, end);
+                estimate.swaps += Migrate(bank, config.threshold);
+            }
+        }
+
+        return estimate;
+    }
+
+private:
+    struct BankState {
+        std::vector<uint64_t> fast;        // Bitmap: VRN sits in a fast PRN
+        std::vector<double> score;
+        std::vector<uint64_t> activeMask;  // Bitmap: score is non-zero
+        std::vector<uint32_t> active;      // VRNs with a non-zero score
+    };
+
+    static bool Test(const std::vector<uint64_t>& bits, uint64_t VRN) {
+        return (bits[VRN / 64] >> (VRN % 64)) & 1;
+    }
+
+    static void Flip(std::vector<uint64_t>& bits, uint64_t VRN) {
+        bits[VRN / 64] ^= 1ULL << (VRN % 64);
+    }
+
+    // Accesses of the epoch are served by the placement at its start
+    void Count(const BankState& bank, const EpochHistograms& histograms,
+               uint64_t begin, uint64_t end, Estimate& estimate) {
+        const uint32_t *VRN = histograms.VRN.data();
+        const uint32_t *reads = histograms.reads.data();
+        const uint32_t *writes = histograms.writes.data();
+        uint64_t fast = 0, total = 0;
+
+        for (uint64_t i = begin; i < end; i++) {
+            uint64_t accesses = reads[i] + writes[i];
+            total += accesses;
+            fast += Test(bank.fast, VRN[i]) ? accesses : 0;
+        }
+
+        estimate.fastAccesses += fast;
+        estimate.slowAccesses += total - fast;
+    }
+
+    // score = Decay * score + Alpha * writes + Beta * reads
+    void Score(BankState& bank, const EstimatorConfig& config,
+               const EpochHistograms& histograms, uint64_t begin, uint64_t end) {
+        double *score = bank.score.data();
+
+        if (config.decay == 0.0) {
+            for (uint32_t VRN : bank.active) {
+                score[VRN] = 0.0;
+            }
+            bank.active.clear();
+            std::fill(bank.activeMask.begin(), bank.activeMask.end(), 0);
+        } else {
+            size_t kept = 0;
+            for (uint32_t VRN : bank.active) {
+                score[VRN] *= config.decay;
+                if (score[VRN] < MIN_SCORE) {
+                    score[VRN] = 0.0;
+                    Flip(bank.activeMask, VRN);
+                } else {
+                    bank.active[kept++] = VRN;
+                }
+            }
+            bank.active.resize(kept);
+        }
+
+        for (uint64_t i = begin; i < end; i++) {
+            uint32_t VRN = histograms.VRN[i];
+            score[VRN] += config.alpha * histograms.writes[i]
+                        + config.beta * histograms.reads[i];
+            if (score[VRN] >= MIN_SCORE && !Test(bank.activeMask, VRN)) {
+                Flip(bank.activeMask, VRN);
+                bank.active.push_back(VRN);
+            }
+        }
+    }
+
+    /*
+     * ThresholdPolicy on the active regions: slow regions by falling score
+     * pair with fast regions by rising score (idle fast regions first, by
+     * VRN) while the difference exceeds the threshold.
+     */
+    uint64_t Migrate(BankState& bank, double threshold) {
+        const double *score = bank.score.data();
+
+        hot.clear();
+        busyFast.clear();
+        for (uint32_t VRN : bank.active) {
+            if (Test(bank.fast, VRN)) {
+                busyFast.push_back(VRN);
+            } else if (score[VRN] > threshold) {
+                hot.push_back(VRN);
+            }
+        }
+
+        if (hot.empty()) {
+            return 0;
+        }
+
+        std::sort(hot.begin(), hot.end(), [score](uint32_t a, uint32_t b) {
+            return score[a] > score[b] || (score[a] == score[b] && a < b);
+        });
+
+        // Idle fast regions (score 0) in VRN order, as many as needed
+        cold.clear();
+        for (uint64_t w = 0; w < numWords && cold.size() < hot.size(); w++) {
+            uint64_t idle = bank.fast[w] & ~bank.activeMask[w];
+            while (idle && cold.size() < hot.size()) {
+                uint64_t bit = __builtin_ctzll(idle);
+                cold.push_back(static_cast<uint32_t>(w * 64 + bit));
+                idle &= idle - 1;
+            }
+        }
+
+        if (cold.size() < hot.size()) {
+            std::sort(busyFast.begin(), busyFast.end(),
+                      [score](uint32_t a, uint32_t b) {
+                          return score[a] < score[b]
+                              || (score[a] == score[b] && a < b);
+                      });
+            cold.insert(cold.end(), busyFast.begin(), busyFast.end());
+        }
+
+        uint64_t swaps = 0;
+        for (size_t i = 0; i < hot.size() && i < cold.size(); i++) {
+            if (score[hot[i]] - score[cold[i]] <= threshold) {
+                break;
+            }
+            Flip(bank.fast, hot[i]);
+            Flip(bank.fast, cold[i]);
+            swaps++;
+        }
+
+        return swaps;
+    }
+
+    const RegionGeometry& geometry;
+    uint64_t numBanks;
+    uint64_t numRegions;
+    uint64_t numWords;
+    std::vector<uint64_t> identityFast;
+    std::vector<BankState> banks;
+
+    // Scratch space for Migrate
+    std::vector<uint32_t> hot;
+    std::vector<uint32_t> cold;
+    std::vector<uint32_t> busyFast;
+};
+
+static bool ParseList(const std::string& text, std::vector<double>& values) {
+    values.clear();
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        char *end;
+        double value = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0') {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+/*
+ * Read one statistics dump of a full gem5/NVMain run: dump (1-based) of the
+ * file, or the last one if dump is 0. A run with --roi dumps once per region
+ * of interest and again at exit, so dumps are never added up. Statistics are
+ * matched by the last component of their name, values of several
+ * controllers are summed up. Returns false if the file has no such dump.
+ */
+static bool ReadStats(const std::string& path, uint64_t dump,
+                      std::map<std::string, double>& stats) {
+    std::vector<std::map<std::string, double>> dumps;
+    std::ifstream file(path);
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.find("Begin Simulation Statistics") != std::string::npos) {
+            dumps.emplace_back();
+            continue;
+        }
+        if (line.find("End Simulation Statistics") != std::string::npos) {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string name, value;
+        if (!(fields >> name >> value)) {
+            continue;
+        }
+        // Files without dump markers are a single dump
+        if (dumps.empty()) {
+            dumps.emplace_back();
+        }
+        std::string::size_type dot = name.rfind('.');
+        std::string key = dot == std::string::npos ? name : name.substr(dot + 1);
+        dumps.back()[key] += std::strtod(value.c_str(), nullptr);
+    }
+
+    if (dumps.empty() || dump > dumps.size()) {
+        return false;
+    }
+    stats = dumps[dump == 0 ? dumps.size() - 1 : dump - 1];
+    return true;
+}
+
+static void PrintUsage() {
+    std::cout << "Usage: analytical_estimator --config <nvmain.config> "
+              << "--trace <trace.nvt|trace.nvmt>" << std::endl
+              << "                            [--alpha a,b,..] [--beta a,b,..]"
+              << std::endl
+              << "                            [--epoch-length a,b,..] "
+              << "[--threshold a,b,..]" << std::endl
+              << "                            [--decay a,b,..] [--threads N] "
+              << "[--top N]" << std::endl
+              << "                            [--csv <file>] "
+              << "[--stats <stats.txt>] [--stats-dump N]" << std::endl
+              << "                            [--order R:RK:BK:CH:C]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::string configFile, traceFile, csvFile, statsFile;
+    std::string alphaList, betaList, epochList, thresholdList, decayList = "0";
+    uint64_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t top = 10;
+    uint64_t statsDump = 0;
+    RegionGeometry geometry;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 1;
+        }
+
+        if (arg == "--config") {
+            configFile = argv[++i];
+        } else if (arg == "--trace") {
+            traceFile = argv[++i];
+        } else if (arg == "--alpha") {
+            alphaList = argv[++i];
+        } else if (arg == "--beta") {
+            betaList = argv[++i];
+        } else if (arg == "--epoch-length") {
+            epochList = argv[++i];
+        } else if (arg == "--threshold") {
+            thresholdList = argv[++i];
+        } else if (arg == "--decay") {
+            decayList = argv[++i];
+        } else if (arg == "--threads") {
+            numThreads = std::max(1ULL, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--top") {
+            top = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--csv") {
+            csvFile = argv[++i];
+        } else if (arg == "--stats") {
+            statsFile = argv[++i];
+        } else if (arg == "--stats-dump") {
+            statsDump = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--order") {
+            geometry.order = argv[++i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (configFile.empty() || traceFile.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    NVMainConfig nvmainConfig;
+    if (!ReadNVMainConfig(configFile, nvmainConfig)) {
+        std::cerr << "Error: cannot read configuration " << configFile << std::endl;
+        return 1;
+    }
+
+    geometry.Configure(nvmainConfig);
+    if (!geometry.Initialize()) {
+        return 1;
+    }
+
+    double fastLatency = ConfigDouble(nvmainConfig, "FastRegionLatency", 50.0);
+    double slowLatency = ConfigDouble(nvmainConfig, "SlowRegionLatency", 120.0);
+
+    // Parameters not swept keep the value of the configuration file, which
+    // is also the parameter set compared against --stats
+    EstimatorConfig base;
+    base.alpha = ConfigDouble(nvmainConfig, "Alpha", 0.5);
+    base.beta = ConfigDouble(nvmainConfig, "Beta", 0.5);
+    base.epochLength = ConfigValue(nvmainConfig, "EpochLength", 1000000);
+    base.threshold = ConfigDouble(nvmainConfig, "MigrationThreshold", 0.0);
+    base.decay = 0.0;
+
+    std::vector<double> alphas(1, base.alpha), betas(1, base.beta);
+    std::vector<double> epochs(1, static_cast<double>(base.epochLength));
+    std::vector<double> thresholds(1, base.threshold), decays;
+    if ((!alphaList.empty() && !ParseList(alphaList, alphas))
+        || (!betaList.empty() && !ParseList(betaList, betas))
+        || (!epochList.empty() && !ParseList(epochList, epochs))
+        || (!thresholdList.empty() && !ParseList(thresholdList, thresholds))
+        || !ParseList(decayList, decays)) {
+        std::cerr << "Error: parameter lists are comma separated numbers" << std::endl;
+        return 1;
+    }
+
+    std::vector<EstimatorConfig> configs;
+    for (double epoch : epochs) {
+        for (double alpha : alphas) {
+            for (double beta : betas) {
+                for (double threshold : thresholds) {
+                    for (double decay : decays) {
+                        EstimatorConfig config;
+                        config.alpha = alpha;
+                        config.beta = beta;
+                        config.epochLength = static_cast<uint64_t>(epoch);
+                        config.threshold = threshold;
+                        config.decay = decay;
+                        if (config.epochLength == 0 || alpha < 0.0 || beta < 0.0
+                            || threshold < 0.0 || decay < 0.0 || decay >= 1.0) {
+                            std::cerr << "Error: EpochLength must be positive, "
+                                      << "Alpha, Beta and MigrationThreshold "
+                                      << "non-negative and Decay in [0, 1)"
+                                      << std::endl;
+                            return 1;
+                        }
+                        configs.push_back(config);
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ReRAM Analytical Estimator" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "Trace: " << traceFile << std::endl;
+    std::cout << "Parameter sets: " << configs.size() << std::endl;
+
+    // Build one set of histograms per epoch length in a single trace pass
+    TraceSource trace;
+    if (!trace.Open(traceFile, numThreads)) {
+        std::cerr << "Error: " << (trace.Failed() ? "corrupt" : "cannot open")
+                  << " trace " << traceFile << std::endl;
+        return 1;
+    }
+
+    std::map<uint64_t, std::unique_ptr<HistogramBuilder>> builders;
+    for (const EstimatorConfig& config : configs) {
+        if (!builders.count(config.epochLength)) {
+            builders[config.epochLength].reset(
+                new HistogramBuilder(config.epochLength, geometry.NumBanks()));
+        }
+    }
+
+    TraceBlock block;
+    uint64_t totalRequests = 0;
+    while (trace.Next(block)) {
+        for (uint64_t i = 0; i < block.count; i++) {
+            const TraceRequest& request = block.requests[i];
+            RegionLocation location = geometry.Decode(request.address);
+            for (auto& builder : builders) {
+                builder.second->Add(request.cycle, location.globalBank,
+                                    location.VRN, request.op);
+            }
+        }
+        totalRequests += block.count;
+    }
+
+    if (trace.Failed()) {
+        std::cerr << "Error: corrupt trace " << traceFile << std::endl;
+        return 1;
+    }
+
+    std::map<uint64_t, const EpochHistograms*> histograms;
+    for (auto& builder : builders) {
+        histograms[builder.first] = &builder.second->Finish();
+    }
+
+    std::cout << "Requests: " << totalRequests << std::endl;
+
+    // Evaluate all parameter sets, spread over the host cores
+    std::vector<Estimate> estimates(configs.size());
+    std::atomic<uint64_t> next(0);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < std::min<uint64_t>(numThreads, configs.size()); t++) {
+        threads.emplace_back([&]() {
+            Evaluator evaluator(geometry);
+            uint64_t index;
+            while ((index = next++) < configs.size()) {
+                estimates[index] = evaluator.Evaluate(
+                    configs[index], *histograms[configs[index].epochLength]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Evaluated in " << seconds << " s ("
+              << (seconds > 0.0 ? configs.size() / seconds : 0.0)
+              << " parameter sets/s)" << std::endl << std::endl;
+
+    auto averageLatency = [&](const Estimate& e) {
+        uint64_t total = e.fastAccesses + e.slowAccesses;
+        return total ? (e.fastAccesses * fastLatency + e.slowAccesses * slowLatency)
+                       / total
+                     : 0.0;
+    };
+
+    std::vector<uint64_t> ranking(configs.size());
+    for (uint64_t i = 0; i < ranking.size(); i++) {
+        ranking[i] = i;
+    }
+    std::stable_sort(ranking.begin(), ranking.end(), [&](uint64_t a, uint64_t b) {
+        return averageLatency(estimates[a]) < averageLatency(estimates[b]);
+    });
+
+    std::printf("%8s %8s %12s %10s %7s %9s %11s %10s %12s\n", "Alpha", "Beta",
+                "EpochLength", "Threshold", "Decay", "fast %", "avgLatency",
+                "swaps", "rowsMoved");
+    for (uint64_t i = 0; i < std::min<uint64_t>(top, ranking.size()); i++) {
+        const EstimatorConfig& c = configs[ranking[i]];
+        const Estimate& e = estimates[ranking[i]];
+        uint64_t total = e.fastAccesses + e.slowAccesses;
+        std::printf("%8.3f %8.3f %12llu %10.2f %7.3f %8.2f%% %11.2f %10llu %12llu\n",
+                    c.alpha, c.beta,
+                    static_cast<unsigned long long>(c.epochLength),
+                    c.threshold, c.decay,
+                    total ? 100.0 * e.fastAccesses / total : 0.0,
+                    averageLatency(e),
+                    static_cast<unsigned long long>(e.swaps),
+                    static_cast<unsigned long long>(
+                        e.swaps * 2 * geometry.regionSize));
+    }
+
+    if (!csvFile.empty()) {
+        std::ofstream csv(csvFile);
+        csv << "alpha,beta,epochLength,threshold,decay,fastAccesses,"
+            << "slowAccesses,avgLatency,swaps,rowsMoved" << std::endl;
+        for (uint64_t i = 0; i < configs.size(); i++) {
+            const EstimatorConfig& c = configs[i];
+            const Estimate& e = estimates[i];
+            csv << c.alpha << "," << c.beta << "," << c.epochLength << ","
+                << c.threshold << "," << c.decay << "," << e.fastAccesses << ","
+                << e.slowAccesses << "," << averageLatency(e) << "," << e.swaps
+                << "," << e.swaps * 2 * geometry.regionSize << std::endl;
+        }
+        std::cout << std::endl << "All estimates written to " << csvFile << std::endl;
+    }
+
+    if (!statsFile.empty()) {
+        // Validate the configuration file's parameter set against a full run
+        std::map<std::string, double> stats;
+        if (!ReadStats(statsFile, statsDump, stats)) {
+            std::cerr << "Error: " << statsFile << " has no statistics";
+            if (statsDump > 0) {
+                std::cerr << " dump " << statsDump;
+            }
+            std::cerr << std::endl;
+            return 1;
+        }
+        std::map<uint64_t, const EpochHistograms*>::iterator it =
+            histograms.find(base.epochLength);
+        if (it == histograms.end()) {
+            std::cerr << "Error: include the configured EpochLength "
+                      << base.epochLength << " in --epoch-length to validate"
+                      << std::endl;
+            return 1;
+        }
+
+        Evaluator evaluator(geometry);
+        Estimate e = evaluator.Evaluate(base, *it->second);
+
+        std::cout << std::endl << "Validation against " << statsFile << std::endl;
+        const char *names[3] = {"fastRegionAccesses", "slowRegionAccesses",
+                                "totalMigrations"};
+        double estimated[3] = {static_cast<double>(e.fastAccesses),
+                               static_cast<double>(e.slowAccesses),
+                               static_cast<double>(e.swaps)};
+        for (int i = 0; i < 3; i++) {
+            if (!stats.count(names[i])) {
+                std::cout << "  " << names[i] << ": not found in statistics" << std::endl;
+                continue;
+            }
+            double simulated = stats[names[i]];
+            double error = simulated != 0.0
+                         ? 100.0 * (estimated[i] - simulated) / simulated : 0.0;
+            std::printf("  %-20s simulated %14.0f  estimated %14.0f  error %7.2f%%\n",
+                        names[i], simulated, estimated[i], error);
+        }
+    }
+
+    return 0;
+}
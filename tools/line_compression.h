@@ -0,0 +1,157 @@
+/**
+ * Memory Line Compression
+ *
+ * Compressed size of a 64-byte memory line under Base-Delta-Immediate
+ * (BDI) and Frequent Pattern Compression (FPC); a line is stored with the
+ * smaller of the two encodings, or uncompressed if neither helps.
+ *
+ * BDI (Pekhimenko et al.) stores the line as one base and narrow deltas,
+ * with a second, implicit zero base for small values. It tries 8-, 4- and
+ * 2-byte words with 1-, 2- and 4-byte deltas, plus all-zero and repeated
+ * 8-byte value lines. FPC (Alameldeen and Wood) encodes each 32-bit word
+ * with a 3-bit prefix and a pattern: zero run, sign-extended 4/8/16 bits,
+ * halfword padded with zeros, two sign-extended bytes, repeated bytes.
+ *
+ * The checks run over every word of the line with fixed trip counts and
+ * no early exits; at 8 to 16 words per line the compiler unrolls them into
+ * straight-line code, so no SIMD intrinsics are needed.
+ */
+
+#ifndef __TOOLS_LINE_COMPRESSION_H__
+#define __TOOLS_LINE_COMPRESSION_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+static const uint32_t LINE_BYTES = 64;
+
+// Whether every word of size Word fits base + delta or 0 + delta, for
+// a Delta byte signed delta
+template <typename Word, typename Signed, int DeltaBytes>
+inline bool BDIFits(const uint8_t *line) {
+    const int words = LINE_BYTES / sizeof(Word);
+    Word values[words];
+    std::memcpy(values, line, LINE_BYTES);
+
+    // The base is the first word that does not fit the zero base
+    const int64_t limit = int64_t(1) << (8 * DeltaBytes - 1);
+    Word base = 0;
+    for (int i = words - 1; i >= 0; i--) {
+        int64_t value = static_cast<Signed>(values[i]);
+        base = (value < -limit || value >= limit) ? values[i] : base;
+    }
+
+    uint32_t misses = 0;
+    for (int i = 0; i < words; i++) {
+        int64_t zero = static_cast<Signed>(values[i]);
+        int64_t delta = static_cast<Signed>(static_cast<Word>(values[i] - base));
+        misses += ((zero < -limit || zero >= limit)
+                   & (delta < -limit || delta >= limit));
+    }
+    return misses == 0;
+}
+
+inline uint32_t BDISize(const uint8_t *line) {
+    uint64_t words[8];
+    std::memcpy(words, line, LINE_BYTES);
+
+    uint64_t nonzero = 0, differ = 0;
+    for (int i = 0; i < 8; i++) {
+        nonzero |= words[i];
+        differ |= words[i] ^ words[0];
+    }
+    if (nonzero == 0) {
+        return 1;
+    }
+    if (differ == 0) {
+        return 8;
+    }
+
+    // Base plus one delta per word, smallest encoding first
+    uint32_t size = LINE_BYTES;
+    if (BDIFits<uint64_t, int64_t, 1>(line)) size = std::min(size, 8u + 8);
+    if (BDIFits<uint32_t, int32_t, 1>(line)) size = std::min(size, 4u + 16);
+    if (BDIFits<uint64_t, int64_t, 2>(line)) size = std::min(size, 8u + 16);
+    if (BDIFits<uint16_t, int16_t, 1>(line)) size = std::min(size, 2u + 32);
+    if (BDIFits<uint32_t, int32_t, 2>(line)) size = std::min(size, 4u + 32);
+    if (BDIFits<uint64_t, int64_t, 4>(line)) size = std::min(size, 8u + 32);
+    return size;
+}
+
+inline uint32_t FPCSize(const uint8_t *line) {
+    uint32_t words[16];
+    std::memcpy(words, line, LINE_BYTES);
+
+    // Data bits of each word's pattern, prefix added below
+    uint32_t bits = 0, zeroRuns = 0;
+    for (int i = 0; i < 16; i++) {
+        uint32_t w = words[i];
+        int32_t s = static_cast<int32_t>(w);
+        uint32_t lowHalf = w & 0xFFFF, highHalf = w >> 16;
+        bool zero = w == 0;
+        bool se4 = s >= -8 && s < 8;
+        bool se8 = s >= -128 && s < 128;
+        bool se16 = s >= -32768 && s < 32768;
+        bool padded = lowHalf == 0;
+        bool halves = static_cast<int16_t>(lowHalf) >= -128
+                   && static_cast<int16_t>(lowHalf) < 128
+                   && static_cast<int16_t>(highHalf) >= -128
+                   && static_cast<int16_t>(highHalf) < 128;
+        bool repeated = w == (w & 0xFF) * 0x01010101u;
+
+        uint32_t data = zero ? 0 : se4 ? 4 : (se8 || repeated) ? 8
+                      : (se16 || padded || halves) ? 16 : 32;
+        bits += 3 + data;
+
+        // A zero run of up to 8 words shares one prefix and a 3-bit length
+        bool runStart = zero && (i == 0 || words[i - 1] != 0 || i % 8 == 0);
+        zeroRuns += runStart;
+        bits -= zero ? 3 : 0;
+    }
+    bits += zeroRuns * 6;
+    return std::min<uint32_t>((bits + 7) / 8, LINE_BYTES);
+}
+
+// Stored size of the line in bytes, 1 to 64
+inline uint32_t CompressedLineSize(const uint8_t *line) {
+    return std::min(BDISize(line), FPCSize(line));
+}
+
+/*
+ * Compressed size of a line given as hex digits (the data field of an
+ * NVMain trace), 0 if the field is not a 64-byte line.
+ */
+inline uint32_t CompressedLineSize(const std::string& hex) {
+    std::string digits = hex;
+    if (digits.compare(0, 2, "0x") == 0 || digits.compare(0, 2, "0X") == 0) {
+        digits = digits.substr(2);
+    }
+    if (digits.size() != 2 * LINE_BYTES) {
+        return 0;
+    }
+
+    uint8_t line[LINE_BYTES];
+    for (uint32_t i = 0; i < LINE_BYTES; i++) {
+        uint32_t byte = 0;
+        for (int d = 0; d < 2; d++) {
+            char c = digits[2 * i + d];
+            uint32_t nibble;
+            if (c >= '0' && c <= '9') {
+                nibble = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                nibble = c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                nibble = c - 'A' + 10;
+            } else {
+                return 0;
+            }
+            byte = byte << 4 | nibble;
+        }
+        line[i] = static_cast<uint8_t>(byte);
+    }
+    return CompressedLineSize(line);
+}
+
+#endif
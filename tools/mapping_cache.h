@@ -0,0 +1,84 @@
+/**
+ * Region Mapping Cache
+ *
+ * The VRN -> PRN table of a large ReRAM memory is NVM-resident metadata;
+ * the controller only keeps a cache of it, like the mapping cache of an
+ * FTL. Table entries are grouped into metadata lines (EntriesPerLine
+ * consecutive entries); the cache holds lines in a set-associative array
+ * with LRU replacement. Updates after a swap dirty the line, which is
+ * written back to the NVM only when it is evicted, so several swaps that
+ * touch the same line cost one metadata write.
+ */
+
+#ifndef __TOOLS_MAPPING_CACHE_H__
+#define __TOOLS_MAPPING_CACHE_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct MappingCacheResult {
+    bool hit;
+    bool writeback;     // A dirty line was evicted
+};
+
+class MappingCache {
+public:
+    MappingCache() {}
+
+    // numLines lines in total, assoc ways per set
+    void Configure(uint64_t numLines, uint64_t assoc) {
+        assoc = std::max<uint64_t>(std::min(assoc, numLines), 1);
+        numSets = std::max<uint64_t>(numLines / assoc, 1);
+        this->assoc = assoc;
+        ways.assign(numSets * assoc, Way());
+        clock = 0;
+    }
+
+    MappingCacheResult Access(uint64_t line, bool write) {
+        MappingCacheResult result = {false, false};
+        Way *set = &ways[(line % numSets) * assoc];
+        Way *victim = set;
+        clock++;
+
+        for (uint64_t w = 0; w < assoc; w++) {
+            if (set[w].valid && set[w].line == line) {
+                set[w].lastUse = clock;
+                set[w].dirty = set[w].dirty || write;
+                result.hit = true;
+                return result;
+            }
+            if (!set[w].valid) {
+                victim = &set[w];
+            } else if (victim->valid && set[w].lastUse < victim->lastUse) {
+                victim = &set[w];
+            }
+        }
+
+        result.writeback = victim->valid && victim->dirty;
+        victim->valid = true;
+        victim->dirty = write;
+        victim->line = line;
+        victim->lastUse = clock;
+        return result;
+    }
+
+    uint64_t Lines() const {
+        return ways.size();
+    }
+
+private:
+    struct Way {
+        uint64_t line = 0;
+        uint64_t lastUse = 0;
+        bool valid = false;
+        bool dirty = false;
+    };
+
+    std::vector<Way> ways;
+    uint64_t numSets = 1;
+    uint64_t assoc = 1;
+    uint64_t clock = 0;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * Read-Only Mapping Snapshots
+ *
+ * Statistics dumps, heatmap export and monitor threads read the region
+ * table while the replay mutates it on swaps. The writer never changes a
+ * published table: after applying a swap list it publishes a new,
+ * versioned, immutable snapshot by swapping one atomic pointer (RCU
+ * style), and readers only load that pointer. Neither side takes a lock
+ * and readers never wait for the writer or the other way round.
+ *
+ * Old snapshots are reclaimed with epoch-based reclamation. Each reader
+ * owns a slot in a SnapshotDomain and, while inside a read section,
+ * stores the domain epoch it entered at. A publish retires the previous
+ * snapshot at the current epoch and advances the epoch; a retired
+ * snapshot is freed once every reader in a read section entered after
+ * it was retired, so a reader can use the pointer it loaded until it
+ * leaves the section.
+ */
+
+#ifndef __TOOLS_MAPPING_SNAPSHOT_H__
+#define __TOOLS_MAPPING_SNAPSHOT_H__
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// VRN -> PRN table of one bank after a swap list was applied
+struct MappingSnapshot {
+    uint64_t version = 0;   // Publishes by this bank
+    uint64_t epoch = 0;     // Epochs closed when it was published
+    std::vector<uint64_t> PRN;
+};
+
+// Reader registry and reclamation epoch shared by publishers and readers
+class SnapshotDomain {
+public:
+    static const uint64_t MaxReaders = 64;
+    static const uint64_t Idle = std::numeric_limits<uint64_t>::max();
+
+    SnapshotDomain() {
+        for (uint64_t r = 0; r < MaxReaders; r++) {
+            slots[r].epoch.store(Idle);
+            slots[r].used.store(false);
+        }
+    }
+
+    // Returns the reader slot, or MaxReaders if all are taken
+    uint64_t Register() {
+        for (uint64_t r = 0; r < MaxReaders; r++) {
+            bool expected = false;
+            if (slots[r].used.compare_exchange_strong(expected, true)) {
+                return r;
+            }
+        }
+        return MaxReaders;
+    }
+
+    void Unregister(uint64_t reader) {
+        slots[reader].epoch.store(Idle);
+        slots[reader].used.store(false);
+    }
+
+    void Enter(uint64_t reader) {
+        slots[reader].epoch.store(epoch.load());
+    }
+
+    void Exit(uint64_t reader) {
+        slots[reader].epoch.store(Idle, std::memory_order_release);
+    }
+
+    // Returns the epoch a snapshot replaced now is retired at
+    uint64_t Advance() {
+        return epoch.fetch_add(1);
+    }
+
+    // Snapshots retired before this epoch are no longer read
+    uint64_t SafeEpoch() const {
+        uint64_t safe = epoch.load();
+        for (uint64_t r = 0; r < MaxReaders; r++) {
+            uint64_t entered = slots[r].epoch.load();
+            if (entered < safe) {
+                safe = entered;
+            }
+        }
+        return safe;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> used;
+    };
+
+    std::atomic<uint64_t> epoch{1};
+    Slot slots[MaxReaders];
+};
+
+// One writer publishes, any registered reader reads
+template <typename T>
+class SnapshotPublisher {
+public:
+    explicit SnapshotPublisher(SnapshotDomain& domain) : domain(domain) {}
+
+    ~SnapshotPublisher() {
+        delete current.load();
+        for (const Retired& retired : retiredList) {
+            delete retired.snapshot;
+        }
+    }
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    void Publish(T *snapshot) {
+        T *old = current.exchange(snapshot);
+        if (old) {
+            retiredList.push_back(Retired{old, domain.Advance()});
+        }
+        Reclaim();
+    }
+
+    // Only valid inside a read section of a reader of the same domain;
+    // nullptr before the first publish
+    const T *Read() const {
+        return current.load();
+    }
+
+    // Retired snapshots not freed yet
+    uint64_t Retained() const {
+        return retiredList.size();
+    }
+
+    void Reclaim() {
+        if (retiredList.empty()) {
+            return;
+        }
+        uint64_t safe = domain.SafeEpoch();
+        uint64_t kept = 0;
+        for (const Retired& retired : retiredList) {
+            if (retired.epoch < safe) {
+                delete retired.snapshot;
+            } else {
+                retiredList[kept++] = retired;
+            }
+        }
+        retiredList.resize(kept);
+    }
+
+private:
+    struct Retired {
+        T *snapshot;
+        uint64_t epoch;
+    };
+
+    SnapshotDomain& domain;
+    std::atomic<T *> current{nullptr};
+    std::vector<Retired> retiredList;
+};
+
+// A registered reader; Section marks where loaded snapshots are used
+class SnapshotReader {
+public:
+    explicit SnapshotReader(SnapshotDomain& domain)
+        : domain(domain), slot(domain.Register()) {}
+
+    ~SnapshotReader() {
+        if (Registered()) {
+            domain.Unregister(slot);
+        }
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool Registered() const {
+        return slot < SnapshotDomain::MaxReaders;
+    }
+
+    class Section {
+    public:
+        explicit Section(SnapshotReader& reader) : reader(reader) {
+            reader.domain.Enter(reader.slot);
+        }
+
+        ~Section() {
+            reader.domain.Exit(reader.slot);
+        }
+
+    private:
+        SnapshotReader& reader;
+    };
+
+private:
+    SnapshotDomain& domain;
+    uint64_t slot;
+};
+
+#endif
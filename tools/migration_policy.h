@@ -0,0 +1,329 @@
+/**
+ * Migration Policies for Dynamic ReRAM Region Mapping
+ *
+ * At every epoch boundary a migration policy looks at the access counts of
+ * all regions of one bank and decides which hot regions in slow physical
+ * regions swap places with cold regions in fast physical regions.
+ *
+ * The per-region features are passed as a structure of arrays indexed by
+ * VRN, so policies score a whole bank with tight loops over contiguous
+ * arrays that the compiler vectorizes:
+ *   reads, writes  - accesses to the region in the finished epoch
+ *   rowHits        - accesses of those served from an open row buffer
+ *   score          - decayed score, Alpha * writes + Beta * reads
+ *                    - RowHitDiscount * rowHits summed over past epochs
+ *                    with weight Decay per epoch
+ *   fast           - 1 if the region currently sits in a fast PRN
+ *   wear           - lifetime writes to the region's current PRN
+ *
+ * Built-in policies:
+ *   ThresholdPolicy - the Alpha/Beta/MigrationThreshold heuristic of
+ *                     ReRAMRegionController
+ *   LinearPolicy    - a tiny linear model over the features, trained online
+ *                     from the latency saved by keeping a region fast
+ */
+
+#ifndef __TOOLS_MIGRATION_POLICY_H__
+#define __TOOLS_MIGRATION_POLICY_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct RegionFeatures {
+    uint64_t bank = 0;
+
+    std::vector<uint32_t> reads;
+    std::vector<uint32_t> writes;
+    std::vector<uint32_t> rowHits;
+    std::vector<double> score;
+    std::vector<uint8_t> fast;
+    std::vector<uint64_t> wear;
+
+    void Resize(uint64_t numRegions) {
+        reads.assign(numRegions, 0);
+        writes.assign(numRegions, 0);
+        rowHits.assign(numRegions, 0);
+        score.assign(numRegions, 0.0);
+        fast.assign(numRegions, 0);
+        wear.assign(numRegions, 0);
+    }
+
+    uint64_t Size() const {
+        return reads.size();
+    }
+
+    // Fold the finished epoch into the decayed score. Row buffer hits
+    // gain little from a fast region, rowHitDiscount takes them out again.
+    void UpdateScores(double alpha, double beta, double decay,
+                      double rowHitDiscount = 0.0) {
+        const uint64_t n = Size();
+        double *s = score.data();
+        const uint32_t *r = reads.data();
+        const uint32_t *w = writes.data();
+        const uint32_t *h = rowHits.data();
+
+        for (uint64_t i = 0; i < n; i++) {
+            s[i] = decay * s[i] + alpha * w[i] + beta * r[i] - rowHitDiscount * h[i];
+        }
+    }
+
+    // Start counting the next epoch
+    void ClearCounts() {
+        std::fill(reads.begin(), reads.end(), 0);
+        std::fill(writes.begin(), writes.end(), 0);
+        std::fill(rowHits.begin(), rowHits.end(), 0);
+    }
+};
+
+struct RegionSwap {
+    uint64_t bank;
+    uint64_t hotVRN;   // Region in a slow PRN moving to a fast PRN
+    uint64_t coldVRN;  // Region in a fast PRN moving to a slow PRN
+};
+
+struct PolicyParams {
+    double alpha = 0.5;               // Write weight
+    double beta = 0.5;                // Read weight
+    double decay = 0.0;               // Weight of the previous epochs' score
+    double migrationThreshold = 0.0;  // Minimum hot/cold score difference
+    double rowHitDiscount = 0.0;      // Score taken off per row buffer hit,
+                                      // at most min(alpha, beta)
+
+    // LinearPolicy: latency saved per access when served by a fast region,
+    // defaults follow the ~50ns fast / ~120ns slow write latency
+    double readSaving = 0.0;
+    double writeSaving = 70.0;
+    double learningRate = 0.5;        // Normalized LMS step size, 0..2
+
+    // LinearPolicy: a swap costs swapCost and has to pay off within
+    // horizon epochs at the predicted saving
+    double swapCost = 0.0;
+    double horizon = 8.0;
+};
+
+class MigrationPolicy {
+public:
+    virtual ~MigrationPolicy() {}
+
+    virtual std::string Name() const = 0;
+
+    // Append this epoch's swaps for features.bank to swaps
+    virtual void SelectSwaps(const RegionFeatures& features,
+                             std::vector<RegionSwap>& swaps) = 0;
+
+protected:
+    /*
+     * Pair the highest-valued slow regions with the lowest-valued fast
+     * regions, best pair first, as long as the value difference exceeds
+     * the threshold. value holds one entry per region of the bank.
+     */
+    void PairRegions(const RegionFeatures& features,
+                     const std::vector<double>& value, double threshold,
+                     std::vector<RegionSwap>& swaps) {
+        const uint64_t n = features.Size();
+
+        hot.clear();
+        cold.clear();
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            if (features.fast[VRN]) {
+                cold.push_back(VRN);
+            } else {
+                hot.push_back(VRN);
+            }
+        }
+
+        // Only the top candidates can pair up, one per fast region
+        uint64_t k = std::min(hot.size(), cold.size());
+
+        // Ties are broken by VRN to keep the result deterministic
+        auto hotter = [&value](uint64_t a, uint64_t b) {
+            return value[a] > value[b] || (value[a] == value[b] && a < b);
+        };
+        auto colder = [&value](uint64_t a, uint64_t b) {
+            return value[a] < value[b] || (value[a] == value[b] && a < b);
+        };
+
+        std::partial_sort(hot.begin(), hot.begin() + k, hot.end(), hotter);
+        std::partial_sort(cold.begin(), cold.begin() + k, cold.end(), colder);
+
+        for (uint64_t i = 0; i < k; i++) {
+            if (value[hot[i]] - value[cold[i]] <= threshold) {
+                break;
+            }
+            swaps.push_back({features.bank, hot[i], cold[i]});
+        }
+    }
+
+    std::vector<uint64_t> hot;
+    std::vector<uint64_t> cold;
+};
+
+/*
+ * Swap while the decayed score of the hottest slow region exceeds the score
+ * of the coldest fast region by more than MigrationThreshold.
+ */
+class ThresholdPolicy : public MigrationPolicy {
+public:
+    explicit ThresholdPolicy(const PolicyParams& params)
+        : params(params) {
+    }
+
+    std::string Name() const override {
+        return "threshold";
+    }
+
+    void SelectSwaps(const RegionFeatures& features,
+                     std::vector<RegionSwap>& swaps) override {
+        PairRegions(features, features.score, params.migrationThreshold,
+                    swaps);
+    }
+
+private:
+    PolicyParams params;
+};
+
+/*
+ * Predicts the latency a region saves next epoch when it is fast as
+ *     w0 * reads + w1 * writes + w2 * score + w3 * wear + w4
+ * and swaps where the predicted saving difference exceeds
+ * swapCost / horizon. After every epoch the prediction made from the
+ * previous epoch's features is compared to the latency the region
+ * actually could have saved (reads * readSaving + writes * writeSaving)
+ * and the weights take one normalized least-mean-squares step, which keeps
+ * the step size independent of the magnitude of the access counts.
+ *
+ * The weights and the previous epoch's features are the training state of
+ * one bank: every bank needs its own instance, as the replay engine and
+ * the oracle create them.
+ */
+class LinearPolicy : public MigrationPolicy {
+public:
+    static const int NUM_WEIGHTS = 5;
+
+    explicit LinearPolicy(const PolicyParams& params)
+        : params(params) {
+        // Start out as the threshold heuristic on the epoch's counts
+        weights[0] = params.beta;
+        weights[1] = params.alpha;
+        weights[2] = 0.0;
+        weights[3] = 0.0;
+        weights[4] = 0.0;
+    }
+
+    std::string Name() const override {
+        return "linear";
+    }
+
+    void SelectSwaps(const RegionFeatures& features,
+                     std::vector<RegionSwap>& swaps) override {
+        if (previous.valid) {
+            Train(previous, features);
+        }
+
+        Predict(features, prediction);
+        PairRegions(features, prediction, params.swapCost / params.horizon,
+                    swaps);
+
+        // Remember this epoch's features for training at the next epoch
+        previous.reads = features.reads;
+        previous.writes = features.writes;
+        previous.score = features.score;
+        previous.wear = features.wear;
+        previous.valid = true;
+    }
+
+    const double *Weights() const {
+        return weights;
+    }
+
+private:
+    struct EpochFeatures {
+        bool valid = false;
+        std::vector<uint32_t> reads;
+        std::vector<uint32_t> writes;
+        std::vector<double> score;
+        std::vector<uint64_t> wear;
+    };
+
+    void Predict(const RegionFeatures& features, std::vector<double>& out) {
+        const uint64_t n = features.Size();
+        const uint32_t *r = features.reads.data();
+        const uint32_t *w = features.writes.data();
+        const double *s = features.score.data();
+        const uint64_t *wr = features.wear.data();
+        const double w0 = weights[0], w1 = weights[1], w2 = weights[2];
+        const double w3 = weights[3], w4 = weights[4];
+
+        out.resize(n);
+        double *p = out.data();
+        for (uint64_t i = 0; i < n; i++) {
+            p[i] = w0 * r[i] + w1 * w[i] + w2 * s[i]
+                 + w3 * static_cast<double>(wr[i]) + w4;
+        }
+    }
+
+    void Train(const EpochFeatures& state, const RegionFeatures& features) {
+        const uint64_t n = std::min<uint64_t>(state.reads.size(),
+                                              features.Size());
+        const double *s = state.score.data();
+        const double w0 = weights[0], w1 = weights[1], w2 = weights[2];
+        const double w3 = weights[3], w4 = weights[4];
+        double gradient[NUM_WEIGHTS] = {0.0, 0.0, 0.0, 0.0, 0.0};
+        double norm = 0.0;
+
+        for (uint64_t i = 0; i < n; i++) {
+            double r = state.reads[i];
+            double w = state.writes[i];
+            double wr = static_cast<double>(state.wear[i]);
+
+            double predicted = w0 * r + w1 * w + w2 * s[i] + w3 * wr + w4;
+            double observed = params.readSaving * features.reads[i]
+                            + params.writeSaving * features.writes[i];
+            double error = observed - predicted;
+
+            gradient[0] += error * r;
+            gradient[1] += error * w;
+            gradient[2] += error * s[i];
+            gradient[3] += error * wr;
+            gradient[4] += error;
+            norm += r * r + w * w + s[i] * s[i] + wr * wr + 1.0;
+        }
+
+        if (n == 0) {
+            return;
+        }
+
+        for (int i = 0; i < NUM_WEIGHTS; i++) {
+            weights[i] += params.learningRate * gradient[i] / norm;
+        }
+
+        // Wear belongs to the physical region and moves with every swap, so
+        // it may only argue against keeping a region fast. A positive weight
+        // would pull the cold region straight back into the worn fast region.
+        weights[3] = std::min(weights[3], 0.0);
+    }
+
+    PolicyParams params;
+    double weights[NUM_WEIGHTS];
+    EpochFeatures previous;     // Features the last prediction was made from
+    std::vector<double> prediction;
+};
+
+// nullptr for an unknown name or parameters the policy cannot work with
+inline MigrationPolicy *CreateMigrationPolicy(const std::string& name,
+                                              const PolicyParams& params) {
+    if (name == "threshold") {
+        return new ThresholdPolicy(params);
+    } else if (name == "linear") {
+        // The swap threshold is swapCost / horizon
+        if (!(params.horizon > 0)) {
+            return nullptr;
+        }
+        return new LinearPolicy(params);
+    }
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * MLC Program-and-Verify Write Model
+ *
+ * A multi-level ReRAM cell stores 2 bits as one of four resistance
+ * levels. A write programs the cells of a line with repeated
+ * program-and-verify pulses until every cell verifies at its target
+ * level; intermediate levels need more pulses than the fully SET or RESET
+ * levels. The cells of a line are pulsed in parallel and the line
+ * terminates early, as soon as its slowest cell verifies, so the line's
+ * write time is the maximum iteration count over its cells.
+ *
+ * Per-cell iteration counts come from a table per level with 16 equally
+ * likely entries (a quantized distribution). The level of a cell is taken
+ * from the written data; which entry a cell draws depends on the data and
+ * the cell's physical row, so a given write always takes the same time.
+ * Cells in slow regions (far from the drivers) need SlowScale percent of
+ * the iterations of fast-region cells.
+ *
+ * The trace only carries a 64-bit hash of the data, so 32 two-bit cells
+ * stand in for the line. A compressed line programs only its first cells.
+ */
+
+#ifndef __TOOLS_MLC_WRITE_H__
+#define __TOOLS_MLC_WRITE_H__
+
+#include <algorithm>
+#include <cstdint>
+
+struct MLCParams {
+    static const int LEVELS = 4;
+    static const int ENTRIES = 16;
+
+    uint64_t iterationCycles = 20;  // One program-and-verify pulse
+    uint64_t slowScale = 150;       // Percent iterations in slow regions
+
+    // Iterations per level: 00 (SET), 01, 10, 11 (RESET)
+    uint8_t iterations[LEVELS][ENTRIES] = {
+        {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+        {2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5},
+        {2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 5, 5, 6},
+        {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2},
+    };
+};
+
+class MLCWriteModel {
+public:
+    static const int CELLS = 32;
+
+    explicit MLCWriteModel(const MLCParams& params) : params(params) {}
+
+    // Iterations until the last of the first cells of the line verifies
+    uint64_t Iterations(uint64_t data, uint64_t row, bool fast,
+                        int cells = CELLS) const {
+        uint64_t noise[2];
+        noise[0] = Mix(data ^ (row * 0x9E3779B97F4A7C15ULL));
+        noise[1] = Mix(noise[0]);
+
+        uint64_t worst = 0;
+        for (int cell = 0; cell < cells; cell++) {
+            uint64_t level = (data >> (2 * cell)) & 3;
+            uint64_t entry = (noise[cell / 16] >> (4 * (cell % 16))) & 15;
+            worst = std::max<uint64_t>(worst, params.iterations[level][entry]);
+        }
+
+        if (!fast) {
+            worst = (worst * params.slowScale + 99) / 100;
+        }
+        return worst;
+    }
+
+    uint64_t Cycles(uint64_t iterations) const {
+        return iterations * params.iterationCycles;
+    }
+
+private:
+    // SplitMix64 finalizer
+    static uint64_t Mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    const MLCParams& params;
+};
+
+#endif
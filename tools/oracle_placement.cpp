@@ -0,0 +1,584 @@
+/**
+ * Oracle Placement Analyzer for Dynamic ReRAM Region Mapping
+ *
+ * Replays a recorded NVMain request trace against the region geometry of
+ * an NVMain configuration and reports, per placement strategy, how many
+ * accesses hit fast regions and the resulting access latency:
+ *   static         - identity mapping, no migration
+ *   online         - a migration policy (tools/migration_policy.h) deciding
+ *                    at each epoch boundary from the finished epoch, one
+ *                    policy instance per bank
+ *   oracle         - per epoch, the K most accessed regions of each bank sit
+ *                    in the K fast regions (future knowledge), migration is
+ *                    free
+ *   oracle+cost    - every region moved into a fast region pays SwapCost
+ *                    cycles; each epoch's placement maximizes the latency
+ *                    saved over the next --lookahead epochs minus the swaps
+ *                    needed from the previous placement
+ *
+ * Banks are independent, so the trace is streamed in blocks that are split
+ * by bank and handed to worker threads, each owning a fixed set of banks.
+ *
+ * Usage:
+ *   oracle_placement --config <nvmain.config> --trace <trace.nvt|trace.nvmt>
+ *                    [--threads N] [--policy threshold|linear]
+ *                    [--swap-cost cycles] [--lookahead epochs]
+ *                    [--order R:RK:BK:CH:C]
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "migration_policy.h"
+#include "region_geometry.h"
+#include "trace_reader.h"
+#include "trace_request.h"
+
+// Bounded FIFO between the trace reader and a worker thread
+template<typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t capacity) : capacity(capacity) {}
+
+    void Push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return items.size() < capacity; });
+        items.push(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    T Pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !items.empty(); });
+        T item = std::move(items.front());
+        items.pop();
+        notFull.notify_one();
+        return item;
+    }
+
+private:
+    size_t capacity;
+    std::queue<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+struct BankAccess {
+    uint64_t cycle;
+    uint32_t bank;     // Global bank
+    uint32_t VRN;
+    uint8_t op;
+};
+
+// An empty batch tells the worker that the trace has ended
+typedef std::vector<BankAccess> AccessBatch;
+
+struct AnalyzerParams {
+    uint64_t epochLength = 1000000;
+    double fastLatency = 50.0;
+    double slowLatency = 120.0;
+    double swapCost = 0.0;
+    uint64_t lookahead = 8;      // Epochs the oracle with cost looks ahead
+    std::string policy = "threshold";
+    PolicyParams policyParams;
+};
+
+struct PlacementResult {
+    uint64_t fastAccesses = 0;
+    uint64_t slowAccesses = 0;
+    uint64_t migrations = 0;
+    double latency = 0.0;
+
+    void Add(const PlacementResult& other) {
+        fastAccesses += other.fastAccesses;
+        slowAccesses += other.slowAccesses;
+        migrations += other.migrations;
+        latency += other.latency;
+    }
+};
+
+enum Strategy {
+    STATIC = 0,
+    ONLINE,
+    ORACLE,
+    ORACLE_COST,
+    NUM_STRATEGIES
+};
+
+static const char *strategyNames[NUM_STRATEGIES] = {
+    "static", "online", "oracle", "oracle+cost"
+};
+
+/*
+ * Mark the k regions with the highest value in selected. Ties keep the
+ * regions that are already fast, then go to the lower VRN, so idle regions
+ * are never moved and the result does not depend on the thread schedule.
+ */
+static void SelectTopK(const std::vector<double>& value,
+                       const std::vector<uint8_t>& incumbent, uint64_t k,
+                       std::vector<uint64_t>& order,
+                       std::vector<uint8_t>& selected) {
+    const uint64_t n = value.size();
+
+    order.resize(n);
+    for (uint64_t i = 0; i < n; i++) {
+        order[i] = i;
+    }
+
+    k = std::min(k, n);
+    std::nth_element(order.begin(), order.begin() + k, order.end(),
+                     [&value, &incumbent](uint64_t a, uint64_t b) {
+                         if (value[a] != value[b]) {
+                             return value[a] > value[b];
+                         }
+                         if (incumbent[a] != incumbent[b]) {
+                             return incumbent[a] > incumbent[b];
+                         }
+                         return a < b;
+                     });
+
+    selected.assign(n, 0);
+    for (uint64_t i = 0; i < k; i++) {
+        selected[order[i]] = 1;
+    }
+}
+
+class BankAnalyzer {
+public:
+    BankAnalyzer(uint64_t bank, const RegionGeometry& geometry,
+                 const AnalyzerParams& params)
+        : geometry(geometry), params(params),
+          policy(CreateMigrationPolicy(params.policy, params.policyParams)) {
+        const uint64_t n = geometry.RegionsPerBank();
+
+        features.Resize(n);
+        features.bank = bank;
+        PRN.resize(n);
+        prnWrites.assign(n, 0);
+        identityFast.resize(n);
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            PRN[VRN] = VRN;
+            identityFast[VRN] = geometry.IsFastPRN(VRN);
+            features.fast[VRN] = identityFast[VRN];
+        }
+        oracleFast = identityFast;
+        oracleCostFast = identityFast;
+        windowSum.assign(n, 0);
+        value.resize(n);
+    }
+
+    void Access(const BankAccess& access) {
+        uint64_t epoch = access.cycle / params.epochLength;
+        while (currentEpoch < epoch) {
+            CloseEpoch();
+        }
+
+        epochAccesses++;
+        Count(results[STATIC], identityFast[access.VRN]);
+        Count(results[ONLINE], features.fast[access.VRN]);
+
+        if (access.op == TRACE_WRITE) {
+            features.writes[access.VRN]++;
+            features.wear[access.VRN]++;
+            prnWrites[PRN[access.VRN]]++;
+        } else {
+            features.reads[access.VRN]++;
+        }
+    }
+
+    void Finish() {
+        CloseEpoch();
+        while (!window.empty()) {
+            PlaceOracleCost();
+        }
+    }
+
+    const PlacementResult& Result(Strategy strategy) const {
+        return results[strategy];
+    }
+
+private:
+    void Count(PlacementResult& result, bool fast) {
+        if (fast) {
+            result.fastAccesses++;
+            result.latency += params.fastLatency;
+        } else {
+            result.slowAccesses++;
+            result.latency += params.slowLatency;
+        }
+    }
+
+    void CountEpoch(PlacementResult& result, const std::vector<uint32_t>& accesses,
+                    const std::vector<uint8_t>& fast) {
+        const uint64_t n = accesses.size();
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            if (fast[VRN]) {
+                result.fastAccesses += accesses[VRN];
+                result.latency += accesses[VRN] * params.fastLatency;
+            } else {
+                result.slowAccesses += accesses[VRN];
+                result.latency += accesses[VRN] * params.slowLatency;
+            }
+        }
+    }
+
+    /*
+     * Place the oldest epoch of the lookahead window: a region is worth the
+     * latency it saves over the whole window, minus a swap if it has to move
+     * into a fast region.
+     */
+    void PlaceOracleCost() {
+        const uint64_t n = value.size();
+        const double saving = params.slowLatency - params.fastLatency;
+        const std::vector<uint32_t>& accesses = window.front();
+
+        if (windowAccesses > 0) {
+            for (uint64_t VRN = 0; VRN < n; VRN++) {
+                value[VRN] = windowSum[VRN] * saving
+                           - (oracleCostFast[VRN] ? 0.0 : params.swapCost);
+            }
+            SelectTopK(value, oracleCostFast, geometry.FastRegionsPerBank(),
+                       order, selected);
+            for (uint64_t VRN = 0; VRN < n; VRN++) {
+                if (selected[VRN] && !oracleCostFast[VRN]) {
+                    results[ORACLE_COST].migrations++;
+                    results[ORACLE_COST].latency += params.swapCost;
+                }
+            }
+            oracleCostFast.swap(selected);
+            CountEpoch(results[ORACLE_COST], accesses, oracleCostFast);
+        }
+
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            windowSum[VRN] -= accesses[VRN];
+            windowAccesses -= accesses[VRN];
+        }
+        window.pop_front();
+    }
+
+    void CloseEpoch() {
+        const uint64_t n = value.size();
+
+        std::vector<uint32_t> accesses(n);
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            accesses[VRN] = features.reads[VRN] + features.writes[VRN];
+        }
+
+        // Oracle: the epoch's most accessed regions are fast. Idle epochs
+        // keep the placement.
+        if (epochAccesses > 0) {
+            for (uint64_t VRN = 0; VRN < n; VRN++) {
+                value[VRN] = accesses[VRN];
+            }
+            SelectTopK(value, oracleFast, geometry.FastRegionsPerBank(),
+                       order, selected);
+            CountEpoch(results[ORACLE], accesses, selected);
+            for (uint64_t VRN = 0; VRN < n; VRN++) {
+                results[ORACLE].migrations += selected[VRN] && !oracleFast[VRN];
+            }
+            oracleFast.swap(selected);
+        }
+
+        // Oracle with cost: decided once the lookahead window is complete
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            windowSum[VRN] += accesses[VRN];
+        }
+        windowAccesses += epochAccesses;
+        window.push_back(std::move(accesses));
+        if (window.size() >= params.lookahead) {
+            PlaceOracleCost();
+        }
+
+        // Online: decide from the finished epoch, effective from the next
+        features.UpdateScores(params.policyParams.alpha,
+                              params.policyParams.beta,
+                              params.policyParams.decay);
+        swaps.clear();
+        policy->SelectSwaps(features, swaps);
+        for (const RegionSwap& swap : swaps) {
+            std::swap(PRN[swap.hotVRN], PRN[swap.coldVRN]);
+            std::swap(features.fast[swap.hotVRN], features.fast[swap.coldVRN]);
+            features.wear[swap.hotVRN] = prnWrites[PRN[swap.hotVRN]];
+            features.wear[swap.coldVRN] = prnWrites[PRN[swap.coldVRN]];
+        }
+        results[ONLINE].migrations += swaps.size();
+        results[ONLINE].latency += swaps.size() * params.swapCost;
+        features.ClearCounts();
+
+        epochAccesses = 0;
+        currentEpoch++;
+    }
+
+    const RegionGeometry& geometry;
+    const AnalyzerParams& params;
+    std::unique_ptr<MigrationPolicy> policy;    // Trained on this bank only
+
+    uint64_t currentEpoch = 0;
+    uint64_t epochAccesses = 0;
+    RegionFeatures features;
+    std::vector<uint64_t> PRN;
+    std::vector<uint64_t> prnWrites;
+    std::vector<uint8_t> identityFast;
+    std::vector<uint8_t> oracleFast;
+    std::vector<uint8_t> oracleCostFast;
+    std::vector<RegionSwap> swaps;
+
+    // Future epochs seen by the oracle with cost
+    std::deque<std::vector<uint32_t>> window;
+    std::vector<uint64_t> windowSum;
+    uint64_t windowAccesses = 0;
+
+    // Scratch space for the top-K selection
+    std::vector<double> value;
+    std::vector<uint64_t> order;
+    std::vector<uint8_t> selected;
+
+    PlacementResult results[NUM_STRATEGIES];
+};
+
+class Worker {
+public:
+    Worker(const RegionGeometry& geometry, const AnalyzerParams& params,
+           uint64_t id, uint64_t numWorkers)
+        : queue(4) {
+        for (uint64_t bank = id; bank < geometry.NumBanks(); bank += numWorkers) {
+            analyzers.emplace_back(new BankAnalyzer(bank, geometry, params));
+        }
+        this->numWorkers = numWorkers;
+    }
+
+    void Run() {
+        while (true) {
+            AccessBatch batch = queue.Pop();
+            if (batch.empty()) {
+                break;
+            }
+            for (const BankAccess& access : batch) {
+                // Worker id owns banks id, id + numWorkers, ...
+                analyzers[access.bank / numWorkers]->Access(access);
+            }
+        }
+
+        for (auto& analyzer : analyzers) {
+            analyzer->Finish();
+        }
+    }
+
+    void Collect(PlacementResult *results) const {
+        for (const auto& analyzer : analyzers) {
+            for (int s = 0; s < NUM_STRATEGIES; s++) {
+                results[s].Add(analyzer->Result(static_cast<Strategy>(s)));
+            }
+        }
+    }
+
+    BlockingQueue<AccessBatch> queue;
+
+private:
+    std::vector<std::unique_ptr<BankAnalyzer>> analyzers;
+    uint64_t numWorkers;
+};
+
+static void PrintUsage() {
+    std::cout << "Usage: oracle_placement --config <nvmain.config> "
+              << "--trace <trace.nvt|trace.nvmt>" << std::endl
+              << "                        [--threads N] "
+              << "[--policy threshold|linear]" << std::endl
+              << "                        [--swap-cost cycles] "
+              << "[--lookahead epochs]" << std::endl
+              << "                        [--order R:RK:BK:CH:C]" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::string configFile, traceFile;
+    uint64_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    RegionGeometry geometry;
+    AnalyzerParams params;
+    bool swapCostSet = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 1;
+        }
+
+        if (arg == "--config") {
+            configFile = argv[++i];
+        } else if (arg == "--trace") {
+            traceFile = argv[++i];
+        } else if (arg == "--threads") {
+            numThreads = std::max(1ULL, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--policy") {
+            params.policy = argv[++i];
+        } else if (arg == "--swap-cost") {
+            params.swapCost = std::strtod(argv[++i], nullptr);
+            swapCostSet = true;
+        } else if (arg == "--lookahead") {
+            params.lookahead = std::max(1ULL, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--order") {
+            geometry.order = argv[++i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (configFile.empty() || traceFile.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    NVMainConfig config;
+    if (!ReadNVMainConfig(configFile, config)) {
+        std::cerr << "Error: cannot read configuration " << configFile << std::endl;
+        return 1;
+    }
+
+    geometry.Configure(config);
+    if (!geometry.Initialize()) {
+        return 1;
+    }
+
+    params.epochLength = ConfigValue(config, "EpochLength", params.epochLength);
+    params.fastLatency = ConfigDouble(config, "FastRegionLatency", params.fastLatency);
+    params.slowLatency = ConfigDouble(config, "SlowRegionLatency", params.slowLatency);
+    params.policyParams.alpha = ConfigDouble(config, "Alpha", params.policyParams.alpha);
+    params.policyParams.beta = ConfigDouble(config, "Beta", params.policyParams.beta);
+    params.policyParams.migrationThreshold =
+        ConfigDouble(config, "MigrationThreshold",
+                     params.policyParams.migrationThreshold);
+    params.policyParams.readSaving = params.slowLatency - params.fastLatency;
+    params.policyParams.writeSaving = params.slowLatency - params.fastLatency;
+
+    // Default swap cost: both regions are read and written row by row
+    if (!swapCostSet) {
+        params.swapCost = 2.0 * geometry.regionSize
+                        * (params.fastLatency + params.slowLatency);
+    }
+
+    params.policyParams.swapCost = params.swapCost;
+    params.policyParams.horizon = static_cast<double>(params.lookahead);
+
+    if (params.epochLength == 0) {
+        std::cerr << "Error: EpochLength must be positive" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<MigrationPolicy> check(
+        CreateMigrationPolicy(params.policy, params.policyParams));
+    if (!check) {
+        std::cerr << "Error: unknown policy " << params.policy
+                  << " or invalid policy parameters" << std::endl;
+        return 1;
+    }
+
+    TraceSource trace;
+    if (!trace.Open(traceFile, numThreads)) {
+        std::cerr << "Error: " << (trace.Failed() ? "corrupt" : "cannot open")
+                  << " trace " << traceFile << std::endl;
+        return 1;
+    }
+
+    numThreads = std::min(numThreads, geometry.NumBanks());
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ReRAM Oracle Placement Analysis" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "Trace: " << traceFile << std::endl;
+    std::cout << "Banks: " << geometry.NumBanks() << ", regions per bank: "
+              << geometry.RegionsPerBank() << " ("
+              << geometry.FastRegionsPerBank() << " fast)" << std::endl;
+    std::cout << "Epoch length: " << params.epochLength << " cycles" << std::endl;
+    std::cout << "Swap cost: " << params.swapCost << " cycles" << std::endl;
+    std::cout << "Oracle lookahead: " << params.lookahead << " epochs" << std::endl;
+    std::cout << "Online policy: " << params.policy << std::endl;
+    std::cout << "Threads: " << numThreads << std::endl << std::endl;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    for (uint64_t id = 0; id < numThreads; id++) {
+        workers.emplace_back(new Worker(geometry, params, id, numThreads));
+    }
+    for (uint64_t id = 0; id < numThreads; id++) {
+        threads.emplace_back(&Worker::Run, workers[id].get());
+    }
+
+    // Stream the trace in blocks, split by the worker owning the bank
+    TraceBlock block;
+    std::vector<AccessBatch> batches(numThreads);
+    uint64_t totalRequests = 0;
+
+    while (trace.Next(block)) {
+        for (uint64_t i = 0; i < block.count; i++) {
+            const TraceRequest& request = block.requests[i];
+            RegionLocation location = geometry.Decode(request.address);
+            BankAccess access;
+            access.cycle = request.cycle;
+            access.bank = static_cast<uint32_t>(location.globalBank);
+            access.VRN = static_cast<uint32_t>(location.VRN);
+            access.op = request.op;
+            batches[location.globalBank % numThreads].push_back(access);
+        }
+        totalRequests += block.count;
+
+        for (uint64_t id = 0; id < numThreads; id++) {
+            if (!batches[id].empty()) {
+                workers[id]->queue.Push(std::move(batches[id]));
+                batches[id] = AccessBatch();
+            }
+        }
+    }
+
+    for (uint64_t id = 0; id < numThreads; id++) {
+        workers[id]->queue.Push(AccessBatch());
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (trace.Failed()) {
+        std::cerr << "Error: corrupt trace " << traceFile << std::endl;
+        return 1;
+    }
+
+    PlacementResult results[NUM_STRATEGIES];
+    for (const auto& worker : workers) {
+        worker->Collect(results);
+    }
+
+    std::cout << "Requests: " << totalRequests << std::endl << std::endl;
+
+    double staticLatency = results[STATIC].latency;
+    std::printf("%-12s %14s %10s %12s %16s %12s\n", "Strategy",
+                "fastAccesses", "fast %", "migrations", "latency", "reduction");
+    for (int s = 0; s < NUM_STRATEGIES; s++) {
+        const PlacementResult& r = results[s];
+        uint64_t total = r.fastAccesses + r.slowAccesses;
+        double fastPercent = total ? 100.0 * r.fastAccesses / total : 0.0;
+        double reduction = staticLatency > 0.0
+                         ? 100.0 * (staticLatency - r.latency) / staticLatency
+                         : 0.0;
+        std::printf("%-12s %14llu %9.2f%% %12llu %16.0f %11.2f%%\n",
+                    strategyNames[s],
+                    static_cast<unsigned long long>(r.fastAccesses),
+                    fastPercent,
+                    static_cast<unsigned long long>(r.migrations),
+                    r.latency, reduction);
+    }
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * Region Geometry for Dynamic ReRAM Region Mapping
+ *
+ * Reads the NVMain configuration (ReRAM_DynamicMapping.config) and splits
+ * physical addresses the way ReRAMRegionMapper does:
+ *   address → (channel, rank, bank, row) → VRN = row >> log2(RegionSize)
+ * and classifies physical regions as fast or slow:
+ *   PRN % (MATHeight / RegionSize) < FastRegionsPerMat → fast
+ *
+ * Address fields are taken from the lowest to the highest order of the
+ * mapping string (default R:RK:BK:CH:C, NVMain's AddressMappingScheme
+ * syntax) after dropping the bus offset (log2(BusWidth / 8) bits).
+ */
+
+#ifndef __TOOLS_REGION_GEOMETRY_H__
+#define __TOOLS_REGION_GEOMETRY_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::string> NVMainConfig;
+
+/*
+ * Parse an NVMain configuration file: one "KEY VALUE" pair per line,
+ * ';' starts a comment. Returns false if the file cannot be opened.
+ */
+inline bool ReadNVMainConfig(const std::string& path, NVMainConfig& config) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string::size_type comment = line.find(';');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream fields(line);
+        std::string key, value;
+        if (fields >> key >> value) {
+            config[key] = value;
+        }
+    }
+
+    return true;
+}
+
+inline uint64_t ConfigValue(const NVMainConfig& config, const std::string& key,
+                            uint64_t defaultValue) {
+    NVMainConfig::const_iterator it = config.find(key);
+    if (it == config.end()) {
+        return defaultValue;
+    }
+    return std::strtoull(it->second.c_str(), nullptr, 10);
+}
+
+inline double ConfigDouble(const NVMainConfig& config, const std::string& key,
+                           double defaultValue) {
+    NVMainConfig::const_iterator it = config.find(key);
+    if (it == config.end()) {
+        return defaultValue;
+    }
+    return std::strtod(it->second.c_str(), nullptr);
+}
+
+inline std::string ConfigString(const NVMainConfig& config, const std::string& key,
+                                const std::string& defaultValue) {
+    NVMainConfig::const_iterator it = config.find(key);
+    if (it == config.end()) {
+        return defaultValue;
+    }
+    return it->second;
+}
+
+inline uint64_t Log2(uint64_t value) {
+    uint64_t bits = 0;
+    while ((1ULL << bits) < value) {
+        bits++;
+    }
+    return bits;
+}
+
+struct RegionLocation {
+    uint64_t channel;
+    uint64_t rank;
+    uint64_t bank;
+    uint64_t row;
+    uint64_t globalBank;  // channel, rank and bank flattened
+    uint64_t VRN;
+};
+
+class RegionGeometry {
+public:
+    // Defaults follow ReRAM_DynamicMapping.config
+    uint64_t channels = 2;
+    uint64_t ranks = 2;
+    uint64_t banks = 8;
+    uint64_t rows = 65536;
+    uint64_t cols = 4096;
+    uint64_t busWidth = 64;
+    uint64_t regionSize = 64;
+    uint64_t matHeight = 1024;
+    uint64_t fastRegionsPerMat = 4;
+    std::string order = "R:RK:BK:CH:C";
+
+    void Configure(const NVMainConfig& config) {
+        channels = ConfigValue(config, "CHANNELS", channels);
+        ranks = ConfigValue(config, "RANKS", ranks);
+        banks = ConfigValue(config, "BANKS", banks);
+        rows = ConfigValue(config, "ROWS", rows);
+        cols = ConfigValue(config, "COLS", cols);
+        busWidth = ConfigValue(config, "BusWidth", busWidth);
+        regionSize = ConfigValue(config, "RegionSize", regionSize);
+        matHeight = ConfigValue(config, "MATHeight", matHeight);
+        fastRegionsPerMat = ConfigValue(config, "FastRegionsPerMat",
+                                        fastRegionsPerMat);
+    }
+
+    /*
+     * Compute the address field layout. Returns false and prints the
+     * reason if the geometry or the order string is invalid.
+     */
+    bool Initialize() {
+        if (regionSize == 0 || matHeight % regionSize != 0
+            || rows % regionSize != 0
+            || fastRegionsPerMat > matHeight / regionSize) {
+            std::cerr << "Error: invalid region geometry" << std::endl;
+            return false;
+        }
+
+        vrnShift = Log2(regionSize);
+        regionsPerBank = rows / regionSize;
+        regionsPerMat = matHeight / regionSize;
+        busOffset = Log2(busWidth / 8);
+
+        // The order string lists the highest order field first
+        std::vector<std::string> names;
+        std::istringstream orderFields(order);
+        std::string name;
+        while (std::getline(orderFields, name, ':')) {
+            names.insert(names.begin(), name);
+        }
+
+        if (names.size() != 5) {
+            std::cerr << "Error: address order " << order
+                      << " must contain R, C, BK, RK and CH" << std::endl;
+            return false;
+        }
+
+        uint64_t shift = busOffset;
+        for (const std::string& field : names) {
+            Field *target;
+            uint64_t count;
+            if (field == "R") {
+                target = &row;
+                count = rows;
+            } else if (field == "C") {
+                target = &col;
+                count = cols;
+            } else if (field == "BK") {
+                target = &bank;
+                count = banks;
+            } else if (field == "RK") {
+                target = &rank;
+                count = ranks;
+            } else if (field == "CH") {
+                target = &channel;
+                count = channels;
+            } else {
+                std::cerr << "Error: unknown address field " << field
+                          << " in " << order << std::endl;
+                return false;
+            }
+            *target = Field(shift, count);
+            shift += target->bits;
+        }
+
+        return true;
+    }
+
+    RegionLocation Decode(uint64_t address) const {
+        RegionLocation location;
+        location.channel = channel.Extract(address);
+        location.rank = rank.Extract(address);
+        location.bank = bank.Extract(address);
+        location.row = row.Extract(address);
+        location.globalBank = (location.channel * ranks + location.rank)
+                            * banks + location.bank;
+        location.VRN = location.row >> vrnShift;
+        return location;
+    }
+
+    bool IsFastPRN(uint64_t PRN) const {
+        return (PRN % regionsPerMat) < fastRegionsPerMat;
+    }
+
+    uint64_t MatOfPRN(uint64_t PRN) const {
+        return PRN / regionsPerMat;
+    }
+
+    uint64_t NumBanks() const {
+        return channels * ranks * banks;
+    }
+
+    uint64_t RegionsPerBank() const {
+        return regionsPerBank;
+    }
+
+    uint64_t FastRegionsPerBank() const {
+        return regionsPerBank / regionsPerMat * fastRegionsPerMat;
+    }
+
+private:
+    struct Field {
+        uint64_t shift = 0;
+        uint64_t bits = 0;
+        uint64_t mask = 0;
+
+        Field() {}
+        Field(uint64_t shift, uint64_t count)
+            : shift(shift), bits(Log2(count)), mask((1ULL << bits) - 1) {
+        }
+
+        uint64_t Extract(uint64_t address) const {
+            return (address >> shift) & mask;
+        }
+    };
+
+    Field row, col, bank, rank, channel;
+    uint64_t busOffset = 0;
+    uint64_t vrnShift = 0;
+    uint64_t regionsPerBank = 0;
+    uint64_t regionsPerMat = 0;
+};
+
+#endif
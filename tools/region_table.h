@@ -0,0 +1,204 @@
+/**
+ * Region Tables
+ *
+ * Region tables start as the identity mapping (VRN n is stored in PRN n)
+ * and only the regions moved by migrations differ from it. A
+ * SparseRegionTable stores just those entries in a compact open-addressing
+ * hash table (linear probing, Fibonacci hashing, load factor <= 1/2), and
+ * every key that is not stored maps to the identity value supplied by the
+ * caller. Creating a table is O(1) and its memory grows with the number of
+ * migrated regions, not with capacity. Setting an entry back to its
+ * identity value removes it.
+ *
+ * A HierarchicalRegionTable is sized from the actual geometry (banks and
+ * regions per bank, no bit packing of the key) as a directory of leaf
+ * pages. Leaves are allocated on the first write to one of their regions;
+ * a missing leaf reads as identity. A lookup is at most two dependent
+ * loads (directory, then leaf), and memory is the directory plus the
+ * leaves that hold migrated regions.
+ */
+
+#ifndef __TOOLS_REGION_TABLE_H__
+#define __TOOLS_REGION_TABLE_H__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class SparseRegionTable {
+public:
+    SparseRegionTable() {}
+
+    uint64_t Get(uint64_t key, uint64_t identity) const {
+        if (count == 0) {
+            return identity;
+        }
+
+        // Keys are stored + 1 so that 0 marks an empty slot
+        const uint64_t stored = key + 1;
+        for (uint64_t slot = Hash(key);; slot = (slot + 1) & mask) {
+            const Entry& entry = entries[slot];
+            if (entry.key == stored) {
+                return entry.value;
+            }
+            if (entry.key == 0) {
+                return identity;
+            }
+        }
+    }
+
+    void Set(uint64_t key, uint64_t value, uint64_t identity) {
+        if (value == identity) {
+            Erase(key);
+            return;
+        }
+
+        if (2 * (count + 1) > entries.size()) {
+            Grow();
+        }
+
+        const uint64_t stored = key + 1;
+        uint64_t slot = Hash(key);
+        while (entries[slot].key != 0 && entries[slot].key != stored) {
+            slot = (slot + 1) & mask;
+        }
+        if (entries[slot].key == 0) {
+            count++;
+        }
+        entries[slot].key = stored;
+        entries[slot].value = value;
+    }
+
+    // Entries that differ from the identity mapping
+    uint64_t Size() const {
+        return count;
+    }
+
+    uint64_t MemoryBytes() const {
+        return entries.size() * sizeof(Entry);
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint64_t value;
+    };
+
+    uint64_t Hash(uint64_t key) const {
+        return (key * 0x9E3779B97F4A7C15ULL) >> shift;
+    }
+
+    void Grow() {
+        std::vector<Entry> old;
+        old.swap(entries);
+
+        uint64_t size = old.empty() ? 16 : 2 * old.size();
+        entries.assign(size, Entry{0, 0});
+        mask = size - 1;
+        shift = 64;
+        for (uint64_t s = size; s > 1; s >>= 1) {
+            shift--;
+        }
+
+        count = 0;
+        for (const Entry& entry : old) {
+            if (entry.key != 0) {
+                uint64_t slot = Hash(entry.key - 1);
+                while (entries[slot].key != 0) {
+                    slot = (slot + 1) & mask;
+                }
+                entries[slot] = entry;
+                count++;
+            }
+        }
+    }
+
+    // Backward-shift deletion keeps probe sequences intact without tombstones
+    void Erase(uint64_t key) {
+        if (count == 0) {
+            return;
+        }
+
+        const uint64_t stored = key + 1;
+        uint64_t slot = Hash(key);
+        while (entries[slot].key != stored) {
+            if (entries[slot].key == 0) {
+                return;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        uint64_t hole = slot;
+        for (uint64_t next = (hole + 1) & mask; entries[next].key != 0;
+             next = (next + 1) & mask) {
+            // Move the entry into the hole unless its home lies in (hole, next]
+            uint64_t home = Hash(entries[next].key - 1);
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                entries[hole] = entries[next];
+                hole = next;
+            }
+        }
+        entries[hole].key = 0;
+        count--;
+    }
+
+    std::vector<Entry> entries;
+    uint64_t mask = 0;
+    uint64_t shift = 64;
+    uint64_t count = 0;
+};
+
+class HierarchicalRegionTable {
+public:
+    HierarchicalRegionTable(uint64_t numBanks, uint64_t regionsPerBank,
+                            uint64_t leafBits = 10)
+        : leafBits(leafBits), leafMask((1ULL << leafBits) - 1),
+          leavesPerBank((regionsPerBank + leafMask) >> leafBits),
+          directory(numBanks * leavesPerBank) {}
+
+    uint64_t Get(uint64_t bank, uint64_t VRN) const {
+        const uint32_t *leaf = directory[bank * leavesPerBank + (VRN >> leafBits)].get();
+        return leaf ? leaf[VRN & leafMask] : VRN;
+    }
+
+    void Set(uint64_t bank, uint64_t VRN, uint64_t value) {
+        std::unique_ptr<uint32_t[]>& leaf =
+            directory[bank * leavesPerBank + (VRN >> leafBits)];
+        if (!leaf) {
+            if (value == VRN) {
+                return;
+            }
+
+            // New leaves start as identity
+            leaf.reset(new uint32_t[leafMask + 1]);
+            uint64_t first = VRN & ~leafMask;
+            for (uint64_t i = 0; i <= leafMask; i++) {
+                leaf[i] = static_cast<uint32_t>(first + i);
+            }
+            numLeaves++;
+        }
+        leaf[VRN & leafMask] = static_cast<uint32_t>(value);
+    }
+
+    uint64_t Leaves() const {
+        return numLeaves;
+    }
+
+    uint64_t LeafSize() const {
+        return leafMask + 1;
+    }
+
+    uint64_t MemoryBytes() const {
+        return directory.size() * sizeof(directory[0])
+             + numLeaves * (leafMask + 1) * sizeof(uint32_t);
+    }
+
+private:
+    uint64_t leafBits;
+    uint64_t leafMask;
+    uint64_t leavesPerBank;
+    std::vector<std::unique_ptr<uint32_t[]>> directory;
+    uint64_t numLeaves = 0;
+};
+
+#endif
@@ -0,0 +1,1726 @@
+/**
+ * Parallel Trace Replay Engine
+ *
+ * Replays a request trace against a timing model of the ReRAM memory with
+ * dynamic region mapping. Requests to different banks interact only
+ * through the controller queue and the data bus of their channel, so the
+ * replay is split in phases per block of requests:
+ *
+ *   1. Bank phase (parallel over banks): region translation, fast/slow
+ *      service latency, epoch accounting and migrations. This state is
+ *      private to a bank and depends only on the bank's own requests.
+ *      At the end of the phase every bank catches up to the last request
+ *      of the block (closes its epochs, applies its decisions).
+ *   2. Migration scheduling (serial, migrations only): the migrations of
+ *      every applied decision are started by a global token bucket, see
+ *      below.
+ *   3. Channel phase (parallel over channels): the timing recurrence that
+ *      couples the banks of a channel, in trace order:
+ *        admit    = max(arrival, completion of the request QueueSize back)
+ *        start    = max(admit, mat group free [+ migrations, scrubs])
+ *        ready    = start + service latency
+ *        complete = max(ready, bus free [+ migration transfers]) + tBURST
+ *
+ * With MappingCacheEntries > 0 the region table is NVM-resident metadata
+ * behind a mapping cache (tools/mapping_cache.h). The cache is banked: each
+ * bank caches the lines of its own table, stored in that bank, so misses
+ * add metadata reads to the bank service latency, and the table updates of
+ * a swap add metadata reads and write-backs to the migration.
+ *
+ * MigrationScheme selects how a hot slow region and a cold fast region
+ * trade places:
+ *   swap   - both regions are buffered and exchanged (SwapCost cycles,
+ *            a buffer of RegionSize rows)
+ *   rotate - each bank keeps one spare physical region (an extra, slow
+ *            region outside the VRN space); the cold region is copied into
+ *            the spare, the hot region into the freed fast slot, and the
+ *            hot region's old slot becomes the spare. Each step is a single
+ *            region copy costing RegionSize * (source + destination
+ *            latency), with a buffer of one row.
+ *
+ * By default migrated rows travel through the controller, so every row
+ * crosses the channel bus twice (MigrationRowBusCycles each way) and
+ * competes with demand requests for the bus. With InBankCopy the bank
+ * copies rows internally (RowClone): RowCloneLatency per row within a mat,
+ * RowCloneBankLatency per row between mats of the bank, and no bus
+ * transfers. A swap then goes through a scratch row of the mat (three
+ * copies per row pair), a rotation needs two.
+ *
+ * Migrations of different banks run concurrently; each migration occupies
+ * only its own bank (and the bus, for controller copies: the transfers
+ * hold the channel bus from the migration's start, so they delay requests
+ * to every bank of the channel that arrive after it). The aggregate
+ * migration bandwidth is capped by a token bucket of one token per moved
+ * row, refilled every MigrationTokenCycles cycles and holding at most
+ * MigrationTokenBurst tokens (GCRA). At each epoch boundary the banks take
+ * turns, one migration each, starting at a different bank every epoch.
+ * MigrationTokenCycles 0 leaves the bandwidth unlimited.
+ *
+ * The swap list of an epoch is decided from a snapshot of the scores at
+ * the boundary and applied DecisionLatency cycles later (the controller
+ * firmware delay); requests in between still see the old mapping and
+ * already count towards the next epoch. With DecisionLatency > 0 each
+ * bank hands the snapshot to its own persistent helper thread, which
+ * computes the decision while the replay goes on; the bank waits for it
+ * when the first request at or after the apply cycle arrives, so the
+ * result does not depend on host timing.
+ *
+ * A bank is split into mats of MATHeight rows. MatGroups independent
+ * subarray groups per bank (mat % MatGroups) overlap operations that
+ * target different groups; 1 serializes the whole bank. Migrations occupy
+ * the groups of every mat they read or write. With MatAwarePlacement the
+ * hot regions of a swap list are assigned to the selected fast slots so
+ * that the hottest region goes to the mat group with the least score,
+ * spreading hot regions across groups.
+ *
+ * Each mat group has a row buffer. PagePolicy closed (the default) closes
+ * it after every access, so all accesses are row misses at the fast/slow
+ * region latency. open keeps the last row open: an access to it is a row
+ * hit (Fast/SlowRowHitLatency), to another row a conflict
+ * (Fast/SlowRowConflictLatency, precharge included). adaptive keeps the
+ * row open while a 2-bit counter predicts another hit; the counter is
+ * raised by hits and lowered by conflicts, including the ones a closed
+ * row avoided. Migrations close the bank's rows. The
+ * row buffer state follows the bank's accesses in trace order, so it is
+ * part of the bank phase.
+ *
+ * With MLCWrites the cells are 2-bit multi-level cells and a write adds
+ * its program-and-verify time to the service latency (tools/mlc_write.h):
+ * the written data selects the cell levels, the line terminates when its
+ * slowest cell verifies, and slow regions take MLCSlowScale percent of the
+ * iterations. The data is the trace's data hash, or the address when the
+ * trace has none.
+ *
+ * With ScrubInterval > 0 every row that holds data is scrubbed (read,
+ * checked and rewritten against resistance drift) once per interval, fast
+ * regions only every ScrubFastPasses intervals. The walk follows the data,
+ * not the physical rows: row i of a pass is row i of the bank's VRNs, in
+ * whichever PRN holds the region when the scrub is issued (a fast slot,
+ * the rotation spare or a spare of a retired region). The empty spare and
+ * retired PRNs are not scrubbed. Row i is released i / rows of the way
+ * into the interval and costs Fast/SlowScrubLatency cycles of its mat
+ * group. Scrubs run in the idle time of their group before the bank's
+ * next request; one still waiting ScrubDeadline cycles after its release
+ * is escalated and runs even if it delays that request. Scrubbing is part
+ * of the channel phase: it depends on the bank's busy time, and the
+ * channel tracks the PRNs from the migration jobs the bank's requests
+ * wait for. Scrubs after a bank's last request are not issued.
+ *
+ * With EnduranceWrites > 0 physical rows wear out: each row survives
+ * EnduranceWrites writes, varied by up to EnduranceVariation percent per
+ * row, and each write counts AgingFactor times (accelerated aging). A
+ * worn-out row has stuck-at cells. Once RetireFailedRows rows of a region
+ * failed, the region is retired with the next applied swap list: its VRN
+ * is copied to one of SpareRegions extra (slow) physical regions of the
+ * bank and the failed region is never mapped again. Without a free spare
+ * the region stays in use and accesses to its failed rows are counted.
+ * When a rotation leaves such a worn-out region as the empty rotation
+ * spare, a free spare replaces it; without one the bank stops rotating
+ * and swaps from then on, counted in sparesLost.
+ *
+ * EccRegions slow (or all) protects slow (or all) regions with error
+ * correction: writes add EccEncodeLatency, reads EccDecodeLatency and,
+ * when the line needs correcting, EccCorrectLatency. A read needs
+ * correcting with probability EccErrorPpm plus EccWearPpm per 1000 writes
+ * to its physical region, drawn from a per-bank sequence, and always when
+ * its row has failed. The write that wears a row out also writes an error
+ * correction pointer (EccPointerLatency).
+ *
+ * With Compression the controller stores lines compressed (BDI/FPC, see
+ * tools/line_compression.h) when the trace records their compressed size:
+ * a write programs only the cells of the compressed line, which shortens
+ * its MLC program-and-verify time, and a read of a compressed line adds
+ * DecompressLatency. Wear counts programmed cells, so a compressed write
+ * ages its row and region by its share of the line's cells.
+ *
+ * TenantQuotas gives each tenant (a requestor ID; requestors past the
+ * last quota share the last tenant) a quota of fast regions per bank, and
+ * TenantBorrowing lets tenants borrow idle ones. Each bank filters its
+ * swap lists through a TenantQuotas (tools/tenant_quota.h) before they
+ * are applied.
+ *
+ * Every applied swap list publishes a read-only snapshot of the bank's
+ * table (tools/mapping_snapshot.h), so monitor threads can read the
+ * mapping while the replay runs without locks on either side.
+ *
+ * Each block is a bounded window: the bank phase of a block only needs the
+ * bank state left by the previous block, the scheduler only the token
+ * bucket, and the channel phase only the previous block's queue and bus
+ * state. All quantities are integer
+ * cycles, so the result is identical to ReplaySerial(), which runs the
+ * same model one request at a time, for any number of threads.
+ */
+
+#ifndef __TOOLS_REPLAY_ENGINE_H__
+#define __TOOLS_REPLAY_ENGINE_H__
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapping_cache.h"
+#include "line_compression.h"
+#include "mapping_snapshot.h"
+#include "migration_policy.h"
+#include "mlc_write.h"
+#include "region_geometry.h"
+#include "tenant_quota.h"
+#include "trace_reader.h"
+#include "trace_request.h"
+
+struct ReplayParams {
+    uint64_t epochLength = 1000000;
+    uint64_t fastLatency = 50;
+    uint64_t slowLatency = 120;
+    uint64_t swapCost = 0;          // Bank busy cycles per region swap
+    std::string migrationScheme = "swap";   // swap or rotate
+    uint64_t migrationRowBusCycles = 0; // Bus cycles to move a row each way
+    bool inBankCopy = false;
+    uint64_t rowCloneLatency = 120;     // Per row, same mat
+    uint64_t rowCloneBankLatency = 170; // Per row, other mat of the bank
+    uint64_t rowMoveEnergy = 0;         // pJ per row moved through the controller
+    uint64_t rowCloneEnergy = 0;        // pJ per row copied in the bank
+    uint64_t migrationTokenCycles = 0;  // 0: unlimited migration bandwidth
+    uint64_t migrationTokenBurst = 128; // Bucket depth in rows
+    uint64_t decisionLatency = 0;   // Boundary to swap list, < epochLength
+    uint64_t matGroups = 1;         // Independent subarray groups per bank, <= 64
+    bool matAwarePlacement = false;
+    std::string pagePolicy = "closed";  // closed, open or adaptive
+    uint64_t fastRowHitLatency = 20;
+    uint64_t slowRowHitLatency = 20;
+    uint64_t fastRowConflictLatency = 70;
+    uint64_t slowRowConflictLatency = 140;
+    uint64_t scrubInterval = 0;     // 0: no scrubbing
+    uint64_t scrubDeadline = 0;     // After release, 0: one interval
+    uint64_t scrubFastPasses = 1;   // Fast regions every N passes
+    uint64_t fastScrubLatency = 50; // Per row
+    uint64_t slowScrubLatency = 120;
+    uint64_t enduranceWrites = 0;   // Per row, 0: no wear-out
+    uint64_t enduranceVariation = 0;    // Percent, uniform per row
+    uint64_t agingFactor = 1;       // Wear per write
+    uint64_t spareRegions = 0;      // Per bank, for retired regions
+    uint64_t retireFailedRows = 1;  // Failed rows that retire a region
+    std::string eccRegions = "off"; // off, slow or all
+    uint64_t eccEncodeLatency = 10;
+    uint64_t eccDecodeLatency = 5;
+    uint64_t eccCorrectLatency = 30;
+    uint64_t eccPointerLatency = 120;
+    uint64_t eccErrorPpm = 100;     // Reads needing correction, per million
+    uint64_t eccWearPpm = 0;        // Added per 1000 writes to the region
+    bool compression = false;
+    uint64_t decompressLatency = 5;
+    bool mlcWrites = false;
+    MLCParams mlc;
+    std::vector<uint64_t> tenantQuotas; // Fast regions per bank, empty: no tenants
+    bool tenantBorrowing = false;
+    uint64_t queueSize = 32;        // Controller queue entries per channel
+    uint64_t burstCycles = 4;       // Data bus cycles per request
+    uint64_t mappingCacheEntries = 0;   // 0: the whole table is in SRAM
+    uint64_t mappingCacheAssoc = 8;
+    uint64_t mappingEntriesPerLine = 16;
+    uint64_t metadataReadLatency = 50;
+    uint64_t metadataWriteLatency = 120;
+    std::string policy = "threshold";
+    PolicyParams policyParams;
+};
+
+// Statistics of one tenant, summed over banks and channels
+struct TenantStats {
+    uint64_t requests = 0;
+    uint64_t fastAccesses = 0;
+    uint64_t totalLatency = 0;
+    uint64_t fastRegions = 0;       // Held per bank, summed over decisions
+
+    void Add(const TenantStats& other) {
+        requests += other.requests;
+        fastAccesses += other.fastAccesses;
+        totalLatency += other.totalLatency;
+        fastRegions += other.fastRegions;
+    }
+
+    bool operator==(const TenantStats& other) const {
+        return requests == other.requests && fastAccesses == other.fastAccesses
+            && totalLatency == other.totalLatency && fastRegions == other.fastRegions;
+    }
+};
+
+struct ReplayStats {
+    uint64_t requests = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t fastAccesses = 0;
+    uint64_t slowAccesses = 0;
+    uint64_t migrations = 0;
+    uint64_t totalLatency = 0;      // Sum of completion - arrival
+    uint64_t queueCycles = 0;       // Waiting for a controller queue entry
+    uint64_t bankCycles = 0;        // Waiting for the bank
+    uint64_t busCycles = 0;         // Waiting for the data bus
+    uint64_t lastCompletion = 0;
+    uint64_t mappingHits = 0;
+    uint64_t mappingMisses = 0;
+    uint64_t metadataReads = 0;
+    uint64_t metadataWrites = 0;
+    uint64_t rowsMoved = 0;
+    uint64_t migrationCycles = 0;   // Bank cycles spent migrating
+    uint64_t migrationBusCycles = 0;    // Bus cycles spent migrating
+    uint64_t rowsCloned = 0;        // Row copies done inside the bank
+    uint64_t migrationEnergy = 0;   // pJ
+    uint64_t migrationDelay = 0;    // Cycles migrations waited for tokens
+    uint64_t matBusyCycles = 0;     // Summed over mat groups
+    uint64_t matBusyMax = 0;        // Busiest mat group
+    uint64_t bankActiveCycles = 0;  // Cycles with at least one group busy
+    uint64_t fastRowHits = 0;
+    uint64_t fastRowMisses = 0;     // No row open
+    uint64_t fastRowConflicts = 0;  // Another row open
+    uint64_t slowRowHits = 0;
+    uint64_t slowRowMisses = 0;
+    uint64_t slowRowConflicts = 0;
+    uint64_t mlcIterations = 0;     // Program-and-verify pulses of all writes
+    uint64_t mlcProgramCycles = 0;
+    uint64_t failedRows = 0;
+    uint64_t regionsRetired = 0;
+    uint64_t regionsUnrepaired = 0; // Worn out with no spare left
+    uint64_t sparesLost = 0;        // Worn rotation spares never replaced
+    uint64_t faultyAccesses = 0;    // To failed rows
+    uint64_t eccEncodes = 0;
+    uint64_t eccDecodes = 0;
+    uint64_t eccCorrections = 0;
+    uint64_t eccPointerUpdates = 0;
+    uint64_t eccCycles = 0;         // Service latency added by ECC
+    uint64_t compressedWrites = 0;
+    uint64_t lineBytesWritten = 0;  // Stored size of the written lines
+    uint64_t lineBytesUncompressed = 0;
+    uint64_t cellsWritten = 0;      // Cells programmed by all writes
+    uint64_t compressionSavedCycles = 0;    // MLC program cycles avoided
+    uint64_t decompressCycles = 0;
+    uint64_t scrubRows = 0;
+    uint64_t scrubCycles = 0;       // Bank cycles spent scrubbing
+    uint64_t scrubEscalations = 0;  // Scrubs forced past their deadline
+    uint64_t scrubDelay = 0;        // Demand cycles lost to escalated scrubs
+    uint64_t quotaDenials = 0;      // Swaps dropped for a tenant quota
+    uint64_t quotaBorrows = 0;      // Promotions past the tenant's quota
+    uint64_t quotaReclaims = 0;     // Demotions of regions held past a quota
+    uint64_t tenantDecisions = 0;   // Per bank, samples of fastRegions
+    std::vector<TenantStats> tenants;
+
+    void Add(const ReplayStats& other) {
+        requests += other.requests;
+        reads += other.reads;
+        writes += other.writes;
+        fastAccesses += other.fastAccesses;
+        slowAccesses += other.slowAccesses;
+        migrations += other.migrations;
+        totalLatency += other.totalLatency;
+        queueCycles += other.queueCycles;
+        bankCycles += other.bankCycles;
+        busCycles += other.busCycles;
+        lastCompletion = std::max(lastCompletion, other.lastCompletion);
+        mappingHits += other.mappingHits;
+        mappingMisses += other.mappingMisses;
+        metadataReads += other.metadataReads;
+        metadataWrites += other.metadataWrites;
+        rowsMoved += other.rowsMoved;
+        migrationCycles += other.migrationCycles;
+        migrationBusCycles += other.migrationBusCycles;
+        rowsCloned += other.rowsCloned;
+        migrationEnergy += other.migrationEnergy;
+        migrationDelay += other.migrationDelay;
+        matBusyCycles += other.matBusyCycles;
+        matBusyMax = std::max(matBusyMax, other.matBusyMax);
+        bankActiveCycles += other.bankActiveCycles;
+        fastRowHits += other.fastRowHits;
+        fastRowMisses += other.fastRowMisses;
+        fastRowConflicts += other.fastRowConflicts;
+        slowRowHits += other.slowRowHits;
+        slowRowMisses += other.slowRowMisses;
+        slowRowConflicts += other.slowRowConflicts;
+        mlcIterations += other.mlcIterations;
+        mlcProgramCycles += other.mlcProgramCycles;
+        failedRows += other.failedRows;
+        regionsRetired += other.regionsRetired;
+        regionsUnrepaired += other.regionsUnrepaired;
+        sparesLost += other.sparesLost;
+        faultyAccesses += other.faultyAccesses;
+        eccEncodes += other.eccEncodes;
+        eccDecodes += other.eccDecodes;
+        eccCorrections += other.eccCorrections;
+        eccPointerUpdates += other.eccPointerUpdates;
+        eccCycles += other.eccCycles;
+        compressedWrites += other.compressedWrites;
+        lineBytesWritten += other.lineBytesWritten;
+        lineBytesUncompressed += other.lineBytesUncompressed;
+        cellsWritten += other.cellsWritten;
+        compressionSavedCycles += other.compressionSavedCycles;
+        decompressCycles += other.decompressCycles;
+        scrubRows += other.scrubRows;
+        scrubCycles += other.scrubCycles;
+        scrubEscalations += other.scrubEscalations;
+        scrubDelay += other.scrubDelay;
+        quotaDenials += other.quotaDenials;
+        quotaBorrows += other.quotaBorrows;
+        quotaReclaims += other.quotaReclaims;
+        tenantDecisions += other.tenantDecisions;
+        if (tenants.size() < other.tenants.size()) {
+            tenants.resize(other.tenants.size());
+        }
+        for (uint64_t i = 0; i < other.tenants.size(); i++) {
+            tenants[i].Add(other.tenants[i]);
+        }
+    }
+
+    bool operator==(const ReplayStats& other) const {
+        return requests == other.requests && reads == other.reads
+            && writes == other.writes && fastAccesses == other.fastAccesses
+            && slowAccesses == other.slowAccesses
+            && migrations == other.migrations
+            && totalLatency == other.totalLatency
+            && queueCycles == other.queueCycles
+            && bankCycles == other.bankCycles && busCycles == other.busCycles
+            && lastCompletion == other.lastCompletion
+            && mappingHits == other.mappingHits
+            && mappingMisses == other.mappingMisses
+            && metadataReads == other.metadataReads
+            && metadataWrites == other.metadataWrites
+            && rowsMoved == other.rowsMoved
+            && migrationCycles == other.migrationCycles
+            && migrationBusCycles == other.migrationBusCycles
+            && rowsCloned == other.rowsCloned
+            && migrationEnergy == other.migrationEnergy
+            && migrationDelay == other.migrationDelay
+            && matBusyCycles == other.matBusyCycles
+            && matBusyMax == other.matBusyMax
+            && bankActiveCycles == other.bankActiveCycles
+            && fastRowHits == other.fastRowHits
+            && fastRowMisses == other.fastRowMisses
+            && fastRowConflicts == other.fastRowConflicts
+            && slowRowHits == other.slowRowHits
+            && slowRowMisses == other.slowRowMisses
+            && slowRowConflicts == other.slowRowConflicts
+            && mlcIterations == other.mlcIterations
+            && mlcProgramCycles == other.mlcProgramCycles
+            && failedRows == other.failedRows
+            && regionsRetired == other.regionsRetired
+            && regionsUnrepaired == other.regionsUnrepaired
+            && sparesLost == other.sparesLost
+            && faultyAccesses == other.faultyAccesses
+            && eccEncodes == other.eccEncodes
+            && eccDecodes == other.eccDecodes
+            && eccCorrections == other.eccCorrections
+            && eccPointerUpdates == other.eccPointerUpdates
+            && eccCycles == other.eccCycles
+            && compressedWrites == other.compressedWrites
+            && lineBytesWritten == other.lineBytesWritten
+            && lineBytesUncompressed == other.lineBytesUncompressed
+            && cellsWritten == other.cellsWritten
+            && compressionSavedCycles == other.compressionSavedCycles
+            && decompressCycles == other.decompressCycles
+            && scrubRows == other.scrubRows
+            && scrubCycles == other.scrubCycles
+            && scrubEscalations == other.scrubEscalations
+            && scrubDelay == other.scrubDelay
+            && quotaDenials == other.quotaDenials
+            && quotaBorrows == other.quotaBorrows
+            && quotaReclaims == other.quotaReclaims
+            && tenantDecisions == other.tenantDecisions
+            && tenants == other.tenants;
+    }
+};
+
+// Epochs whose swap lists have been applied by cycle
+inline uint64_t AppliedEpochs(const ReplayParams& params, uint64_t cycle) {
+    return cycle >= params.decisionLatency
+         ? (cycle - params.decisionLatency) / params.epochLength : 0;
+}
+
+// Tenant of a requestor, 0 without quotas
+inline uint16_t TenantOf(const ReplayParams& params, uint16_t requestor) {
+    if (params.tenantQuotas.empty()) {
+        return 0;
+    }
+    return static_cast<uint16_t>(RequestorTenant(params.tenantQuotas.size(), requestor));
+}
+
+// One region migration, started by the MigrationScheduler
+struct MigrationJob {
+    uint64_t epoch;         // Closed at the end of this epoch
+    uint64_t start;
+    uint32_t cycles;        // Bank busy cycles
+    uint32_t bus;           // Bus cycles of the transfers
+    uint32_t rows;          // Tokens
+    uint64_t groups;        // Mat groups occupied, one bit each
+    uint32_t moves;         // Regions moved, and the PRNs now holding them
+    uint32_t movedVRN[2];
+    uint32_t movedPRN[2];
+};
+
+// A request between the phases
+struct ReplayAccess {
+    uint64_t cycle;
+    uint64_t data;          // Written data hash, MLC write model
+    uint32_t firstJob;      // Migrations of the bank to finish first
+    uint32_t numJobs;
+    uint32_t service;       // Bank service latency
+    uint32_t bank;          // Global bank
+    uint32_t VRN;
+    uint32_t row;           // Row within the bank
+    uint16_t channel;
+    uint8_t group;          // Mat group of the region's PRN
+    uint8_t op;
+    uint8_t lineBytes;      // Compressed size, 0 if unknown
+    uint16_t tenant;
+};
+
+// One persistent background thread that runs a task at a time; the thread
+// is started with the first task and kept until destruction
+class HelperThread {
+public:
+    HelperThread() = default;
+    HelperThread(const HelperThread&) = delete;
+    HelperThread& operator=(const HelperThread&) = delete;
+
+    ~HelperThread() {
+        if (!thread.joinable()) {
+            return;
+        }
+        Wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start.notify_one();
+        thread.join();
+    }
+
+    // Run task on the helper thread once the previous task has finished
+    void Submit(std::function<void()> task) {
+        Wait();
+        if (!thread.joinable()) {
+            thread = std::thread(&HelperThread::Run, this);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->task = std::move(task);
+            busy = true;
+        }
+        start.notify_one();
+    }
+
+    // Block until the last submitted task has finished
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return !busy; });
+    }
+
+private:
+    void Run() {
+        while (true) {
+            std::function<void()> current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [this]() { return stopping || busy; });
+                if (stopping) {
+                    return;
+                }
+                current.swap(task);
+            }
+
+            current();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy = false;
+            }
+            done.notify_one();
+        }
+    }
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    std::function<void()> task;
+    bool busy = false;
+    bool stopping = false;
+};
+
+// Region mapping, epoch and migration state of one bank
+class BankReplay {
+public:
+    BankReplay(uint64_t bank, const RegionGeometry& geometry,
+               const ReplayParams& params, SnapshotDomain& snapshots)
+        : geometry(geometry), params(params),
+          policy(CreateMigrationPolicy(params.policy, params.policyParams)),
+          rotate(params.migrationScheme == "rotate"),
+          lineCells(LINE_BYTES * 8 / (params.mlcWrites ? 2 : 1)),
+          openPage(params.pagePolicy != "closed"),
+          adaptivePage(params.pagePolicy == "adaptive"),
+          mlcModel(params.mlc), eccAll(params.eccRegions == "all"),
+          eccSlow(eccAll || params.eccRegions == "slow"), mapping(snapshots) {
+        const uint64_t n = geometry.RegionsPerBank();
+
+        features.Resize(n);
+        features.bank = bank;
+        PRN.resize(n);
+        // The rotation spare, then the spares for retired regions
+        const uint64_t physical = n + 1 + params.spareRegions;
+        prnWrites.assign(physical, 0);
+        spare = n;
+        for (uint64_t prn = physical; prn > n + 1; prn--) {
+            freeSpares.push_back(prn - 1);
+        }
+        if (params.enduranceWrites > 0) {
+            rowWrites.assign(physical * geometry.regionSize, 0);
+            failedRows.assign(physical, 0);
+        }
+        for (uint64_t VRN = 0; VRN < n; VRN++) {
+            PRN[VRN] = VRN;
+            features.fast[VRN] = geometry.IsFastPRN(VRN);
+        }
+        if (!params.tenantQuotas.empty()) {
+            quotas.reset(new TenantQuotas(params.tenantQuotas, params.tenantBorrowing, n));
+            stats.tenants.resize(params.tenantQuotas.size());
+        }
+        PublishMapping();
+        openRow.assign(params.matGroups, uint64_t(NO_ROW));
+        lastRow.assign(params.matGroups, uint64_t(NO_ROW));
+        pageCounter.assign(params.matGroups, 3);
+
+        // This bank's share of the mapping cache, forward table lines
+        // first, then inverse table lines
+        if (params.mappingCacheEntries > 0) {
+            uint64_t entriesPerLine = params.mappingEntriesPerLine;
+            uint64_t slice = params.mappingCacheEntries / geometry.NumBanks();
+            linesPerTable = (n + entriesPerLine - 1) / entriesPerLine;
+            mappingCache.Configure(std::max<uint64_t>(slice / entriesPerLine, 1),
+                                   params.mappingCacheAssoc);
+        }
+    }
+
+    ~BankReplay() {
+        helper.Wait();
+    }
+
+    // Fill in service latency and the migrations access waits for
+    void Access(ReplayAccess& access) {
+        AdvanceTo(access.cycle);
+
+        const uint64_t applied = AppliedEpochs(params, access.cycle);
+        access.firstJob = static_cast<uint32_t>(consumed);
+        while (consumed < jobs.size() && jobs[consumed].epoch < applied) {
+            consumed++;
+        }
+        access.numJobs = static_cast<uint32_t>(consumed - access.firstJob);
+
+        const uint64_t group = Group(PRN[access.VRN]);
+        access.group = static_cast<uint8_t>(group);
+
+        stats.requests++;
+        if (features.fast[access.VRN]) {
+            stats.fastAccesses++;
+        } else {
+            stats.slowAccesses++;
+        }
+        if (quotas) {
+            quotas->Access(access.VRN, access.tenant);
+            TenantStats& tenant = stats.tenants[access.tenant];
+            tenant.requests++;
+            tenant.fastAccesses += features.fast[access.VRN];
+        }
+        access.service = static_cast<uint32_t>(RowBuffer(access, group));
+
+        const bool compressed = params.compression && access.lineBytes > 0
+                             && access.lineBytes < LINE_BYTES;
+        const uint64_t bytes = compressed ? access.lineBytes : LINE_BYTES;
+        if (compressed && access.op != TRACE_WRITE) {
+            stats.decompressCycles += params.decompressLatency;
+            access.service += static_cast<uint32_t>(params.decompressLatency);
+        }
+        const uint64_t cells = bytes * 8 / (params.mlcWrites ? 2 : 1);
+        if (params.compression && access.op == TRACE_WRITE) {
+            stats.compressedWrites += compressed;
+            stats.lineBytesWritten += bytes;
+            stats.lineBytesUncompressed += LINE_BYTES;
+        }
+
+        if (params.mlcWrites && access.op == TRACE_WRITE) {
+            const bool fast = features.fast[access.VRN];
+            const int cells = static_cast<int>(
+                (bytes * MLCWriteModel::CELLS + LINE_BYTES - 1) / LINE_BYTES);
+            uint64_t iterations = mlcModel.Iterations(access.data, PhysicalRow(access),
+                                                      fast, cells);
+            uint64_t cycles = mlcModel.Cycles(iterations);
+            stats.mlcIterations += iterations;
+            stats.mlcProgramCycles += cycles;
+            access.service += static_cast<uint32_t>(cycles);
+            if (compressed) {
+                stats.compressionSavedCycles += mlcModel.Cycles(
+                    mlcModel.Iterations(access.data, PhysicalRow(access), fast))
+                    - cycles;
+            }
+        }
+
+        if (linesPerTable > 0) {
+            access.service += static_cast<uint32_t>(
+                Metadata(access.VRN / params.mappingEntriesPerLine, false));
+        }
+
+        const bool worn = !rowWrites.empty() && Wear(access, cells);
+        if (eccSlow && (eccAll || !features.fast[access.VRN])) {
+            access.service += static_cast<uint32_t>(Ecc(access, worn));
+        }
+
+        if (access.op == TRACE_WRITE) {
+            stats.writes++;
+            stats.cellsWritten += cells;
+            features.writes[access.VRN]++;
+            prnWrites[PRN[access.VRN]] += cells;
+            features.wear[access.VRN] = RegionWrites(PRN[access.VRN]);
+        } else {
+            stats.reads++;
+            features.reads[access.VRN]++;
+        }
+    }
+
+    // Close the epochs and apply the decisions due by cycle
+    void AdvanceTo(uint64_t cycle) {
+        const uint64_t epoch = cycle / params.epochLength;
+        while (true) {
+            if (pending && (applyAt <= cycle || currentEpoch < epoch)) {
+                ApplyDecision();
+            } else if (currentEpoch < epoch) {
+                CloseEpoch();
+            } else {
+                break;
+            }
+        }
+    }
+
+    // The next migration of epoch that has no start cycle yet
+    MigrationJob *NextUnscheduled(uint64_t epoch) {
+        if (scheduled < jobs.size() && jobs[scheduled].epoch == epoch) {
+            return &jobs[scheduled++];
+        }
+        return nullptr;
+    }
+
+    // Drop the migrations handed to accesses. Invalidates the job indices
+    // of earlier accesses, so only call it once they are timed.
+    void Trim() {
+        jobs.erase(jobs.begin(), jobs.begin() + consumed);
+        scheduled -= consumed;
+        consumed = 0;
+    }
+
+    const std::vector<MigrationJob>& Jobs() const {
+        return jobs;
+    }
+
+    const SnapshotPublisher<MappingSnapshot>& Mapping() const {
+        return mapping;
+    }
+
+    const ReplayStats& Stats() const {
+        return stats;
+    }
+
+private:
+    // Look up a metadata line, returns the cycles spent on the NVM
+    uint64_t Metadata(uint64_t line, bool write) {
+        MappingCacheResult result = mappingCache.Access(line, write);
+        uint64_t cycles = 0;
+        if (result.hit) {
+            stats.mappingHits++;
+        } else {
+            stats.mappingMisses++;
+            stats.metadataReads++;
+            cycles += params.metadataReadLatency;
+        }
+        if (result.writeback) {
+            stats.metadataWrites++;
+            cycles += params.metadataWriteLatency;
+        }
+        return cycles;
+    }
+
+    // Service latency of access, updates the row buffer of its mat group
+    uint64_t RowBuffer(const ReplayAccess& access, uint64_t group) {
+        const bool fast = features.fast[access.VRN];
+        const uint64_t row = PhysicalRow(access);
+        uint64_t& open = openRow[group];
+        uint64_t latency;
+
+        if (open == NO_ROW) {
+            (fast ? stats.fastRowMisses : stats.slowRowMisses)++;
+            latency = fast ? params.fastLatency : params.slowLatency;
+
+            // Train on what an open row would have given
+            if (lastRow[group] == row) {
+                pageCounter[group] = static_cast<uint8_t>(std::min(pageCounter[group] + 1, 3));
+            } else if (lastRow[group] != NO_ROW) {
+                pageCounter[group] = static_cast<uint8_t>(std::max(pageCounter[group] - 1, 0));
+            }
+        } else if (open == row) {
+            (fast ? stats.fastRowHits : stats.slowRowHits)++;
+            features.rowHits[access.VRN]++;
+            latency = fast ? params.fastRowHitLatency : params.slowRowHitLatency;
+            pageCounter[group] = static_cast<uint8_t>(std::min(pageCounter[group] + 1, 3));
+        } else {
+            (fast ? stats.fastRowConflicts : stats.slowRowConflicts)++;
+            latency = fast ? params.fastRowConflictLatency : params.slowRowConflictLatency;
+            pageCounter[group] = static_cast<uint8_t>(std::max(pageCounter[group] - 1, 0));
+        }
+
+        bool keepOpen = openPage && (!adaptivePage || pageCounter[group] >= 2);
+        open = keepOpen ? row : NO_ROW;
+        lastRow[group] = row;
+        return latency;
+    }
+
+    uint64_t PhysicalRow(const ReplayAccess& access) const {
+        return PRN[access.VRN] * geometry.regionSize
+             + access.row % geometry.regionSize;
+    }
+
+    // Endurance of a physical row, EnduranceVariation percent around the mean
+    uint64_t Endurance(uint64_t row) const {
+        uint64_t variation = params.enduranceVariation;
+        if (variation == 0) {
+            return params.enduranceWrites;
+        }
+        uint64_t x = (features.bank << 32 | row) * 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 29)) * 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 32;
+        uint64_t percent = 100 - variation + x % (2 * variation + 1);
+        return std::max<uint64_t>(params.enduranceWrites * percent / 100, 1);
+    }
+
+    // Line writes to a physical region, a compressed write counts its
+    // share of the line's cells
+    uint64_t RegionWrites(uint64_t prn) const {
+        return prnWrites[prn] / lineCells;
+    }
+
+    // Age the accessed row by the cells written, queue its region for
+    // retirement when worn out. Returns whether this access wore the row out.
+    bool Wear(const ReplayAccess& access, uint64_t cells) {
+        const uint64_t row = PhysicalRow(access);
+        const uint64_t endurance = Endurance(row) * lineCells;
+        uint64_t& writes = rowWrites[row];
+        if (writes >= endurance) {
+            stats.faultyAccesses++;
+        }
+        if (access.op != TRACE_WRITE) {
+            return false;
+        }
+
+        const bool failed = writes >= endurance;
+        writes += params.agingFactor * cells;
+        if (failed || writes < endurance) {
+            return false;
+        }
+        stats.failedRows++;
+        const uint64_t prn = row / geometry.regionSize;
+        if (++failedRows[prn] == params.retireFailedRows) {
+            retiring.push_back(prn);
+        }
+        return true;
+    }
+
+    bool RowFailed(uint64_t row) const {
+        return !rowWrites.empty() && rowWrites[row] >= Endurance(row) * lineCells;
+    }
+
+    // Encode, decode and correction cycles of a protected access
+    uint64_t Ecc(const ReplayAccess& access, bool worn) {
+        uint64_t cycles;
+        if (access.op == TRACE_WRITE) {
+            stats.eccEncodes++;
+            cycles = params.eccEncodeLatency;
+            if (worn) {
+                stats.eccPointerUpdates++;
+                cycles += params.eccPointerLatency;
+            }
+        } else {
+            stats.eccDecodes++;
+            cycles = params.eccDecodeLatency;
+
+            uint64_t ppm = params.eccErrorPpm
+                         + params.eccWearPpm * RegionWrites(PRN[access.VRN]) / 1000;
+            uint64_t x = (features.bank << 40 | eccDraws++) * 0x9E3779B97F4A7C15ULL;
+            x = (x ^ (x >> 31)) * 0xBF58476D1CE4E5B9ULL;
+            x ^= x >> 29;
+            if (x % 1000000 < ppm || RowFailed(PhysicalRow(access))) {
+                stats.eccCorrections++;
+                cycles += params.eccCorrectLatency;
+            }
+        }
+        stats.eccCycles += cycles;
+        return cycles;
+    }
+
+    // Move the region off a worn-out PRN into a spare, returns the bank busy cycles
+    uint64_t Retire(uint64_t VRN, uint64_t target, uint64_t& bus) {
+        const uint64_t worn = PRN[VRN];
+        uint64_t cycles = Copy(worn, target, bus);
+        PRN[VRN] = target;
+        stats.rowsMoved += geometry.regionSize;
+        stats.regionsRetired++;
+
+        if (linesPerTable > 0) {
+            const uint64_t perLine = params.mappingEntriesPerLine;
+            cycles += Metadata(VRN / perLine, true);
+            cycles += Metadata(linesPerTable + worn / perLine, true);
+            cycles += Metadata(linesPerTable + target / perLine, true);
+        }
+
+        features.fast[VRN] = false;
+        features.wear[VRN] = RegionWrites(target);
+        return cycles;
+    }
+
+    // Queue one migration job per region retired at this boundary
+    void RetireRegions() {
+        for (uint64_t worn : retiring) {
+            uint64_t VRN = std::find(PRN.begin(), PRN.end(), worn) - PRN.begin();
+            if (VRN == PRN.size()) {
+                ReplaceWornSpare();
+                continue;
+            }
+            if (freeSpares.empty()) {
+                stats.regionsUnrepaired++;
+                continue;
+            }
+            const uint64_t target = freeSpares.back();
+            freeSpares.pop_back();
+
+            MigrationJob job;
+            job.groups = (1ULL << Group(worn)) | (1ULL << Group(target));
+            uint64_t bus = 0;
+            uint64_t cycles = Retire(VRN, target, bus);
+            job.epoch = currentEpoch - 1;
+            job.start = 0;
+            job.cycles = static_cast<uint32_t>(cycles);
+            job.bus = static_cast<uint32_t>(bus);
+            job.rows = static_cast<uint32_t>(geometry.regionSize);
+            job.moves = 1;
+            job.movedVRN[0] = static_cast<uint32_t>(VRN);
+            job.movedPRN[0] = static_cast<uint32_t>(target);
+            jobs.push_back(job);
+            stats.migrationCycles += cycles;
+            stats.migrationBusCycles += bus;
+        }
+    }
+
+    /*
+     * A worn-out rotation spare holds no data, e.g. an unrepaired region
+     * vacated by a rotation: replace it with a free spare, or swap from now
+     * on rather than rotate live data into its failed rows.
+     */
+    void ReplaceWornSpare() {
+        if (failedRows.empty() || failedRows[spare] < params.retireFailedRows) {
+            return;
+        }
+        if (freeSpares.empty()) {
+            rotate = false;
+            stats.sparesLost++;
+            return;
+        }
+        spare = freeSpares.back();
+        freeSpares.pop_back();
+        stats.regionsRetired++;
+    }
+
+    uint64_t Group(uint64_t prn) const {
+        return geometry.MatOfPRN(prn) % params.matGroups;
+    }
+
+    /*
+     * Reassign the fast slots of the swap list: hottest region first, each
+     * to the slot whose mat group holds the least score among the fast
+     * regions that stay. Cold regions all go to slow slots either way.
+     */
+    void SpreadAcrossMats() {
+        groupScore.assign(params.matGroups, 0.0);
+        leaving.assign(PRN.size(), 0);
+        for (const RegionSwap& swap : swaps) {
+            leaving[swap.coldVRN] = 1;
+        }
+        for (uint64_t VRN = 0; VRN < PRN.size(); VRN++) {
+            if (features.fast[VRN] && !leaving[VRN]) {
+                groupScore[Group(PRN[VRN])] += features.score[VRN];
+            }
+        }
+
+        // The policy lists swaps hottest first
+        slots.clear();
+        for (const RegionSwap& swap : swaps) {
+            slots.push_back(swap.coldVRN);
+        }
+        for (RegionSwap& swap : swaps) {
+            uint64_t best = 0;
+            for (uint64_t i = 1; i < slots.size(); i++) {
+                double load = groupScore[Group(PRN[slots[i]])];
+                double bestLoad = groupScore[Group(PRN[slots[best]])];
+                if (load < bestLoad || (load == bestLoad && slots[i] < slots[best])) {
+                    best = i;
+                }
+            }
+            swap.coldVRN = slots[best];
+            groupScore[Group(PRN[slots[best]])] += features.score[swap.hotVRN];
+            slots[best] = slots.back();
+            slots.pop_back();
+        }
+    }
+
+    // The spare region is slow
+    bool IsFast(uint64_t prn) const {
+        return prn < PRN.size() && geometry.IsFastPRN(prn);
+    }
+
+    uint64_t CopyCycles(uint64_t source, uint64_t destination) const {
+        return geometry.regionSize
+             * ((IsFast(source) ? params.fastLatency : params.slowLatency)
+                + (IsFast(destination) ? params.fastLatency : params.slowLatency));
+    }
+
+    // Per row latency of an in-bank copy
+    uint64_t CloneLatency(uint64_t source, uint64_t destination) const {
+        bool sameMat = source < PRN.size() && destination < PRN.size()
+                    && geometry.MatOfPRN(source) == geometry.MatOfPRN(destination);
+        return sameMat ? params.rowCloneLatency : params.rowCloneBankLatency;
+    }
+
+    // Rows moved through the controller cross the bus twice
+    void MoveRows(uint64_t rows, uint64_t& bus) {
+        bus += 2 * rows * params.migrationRowBusCycles;
+        stats.migrationEnergy += rows * params.rowMoveEnergy;
+    }
+
+    void CloneRows(uint64_t rows) {
+        stats.rowsCloned += rows;
+        stats.migrationEnergy += rows * params.rowCloneEnergy;
+    }
+
+    // Copy one region, returns the bank busy cycles
+    uint64_t Copy(uint64_t source, uint64_t destination, uint64_t& bus) {
+        if (params.inBankCopy) {
+            CloneRows(geometry.regionSize);
+            return geometry.regionSize * CloneLatency(source, destination);
+        }
+        MoveRows(geometry.regionSize, bus);
+        return CopyCycles(source, destination);
+    }
+
+    // Exchange the hot and cold regions, returns the bank busy cycles
+    uint64_t Swap(const RegionSwap& swap, uint64_t& bus) {
+        uint64_t hot = PRN[swap.hotVRN], cold = PRN[swap.coldVRN];
+        PRN[swap.hotVRN] = cold;
+        PRN[swap.coldVRN] = hot;
+        stats.rowsMoved += 2 * geometry.regionSize;
+
+        uint64_t cycles;
+        if (params.inBankCopy) {
+            // hot -> scratch, cold -> hot, scratch -> cold, scratch row in the mat
+            CloneRows(3 * geometry.regionSize);
+            cycles = geometry.regionSize
+                   * (2 * params.rowCloneLatency + CloneLatency(cold, hot));
+        } else {
+            MoveRows(2 * geometry.regionSize, bus);
+            cycles = params.swapCost;
+        }
+        if (linesPerTable > 0) {
+            const uint64_t perLine = params.mappingEntriesPerLine;
+            cycles += Metadata(swap.hotVRN / perLine, true);
+            cycles += Metadata(swap.coldVRN / perLine, true);
+            cycles += Metadata(linesPerTable + hot / perLine, true);
+            cycles += Metadata(linesPerTable + cold / perLine, true);
+        }
+        return cycles;
+    }
+
+    // Cold region into the spare, hot region into the freed slot
+    uint64_t Rotate(const RegionSwap& swap, uint64_t& bus) {
+        uint64_t hot = PRN[swap.hotVRN], cold = PRN[swap.coldVRN];
+        uint64_t cycles = Copy(cold, spare, bus) + Copy(hot, cold, bus);
+        PRN[swap.coldVRN] = spare;
+        PRN[swap.hotVRN] = cold;
+        stats.rowsMoved += 2 * geometry.regionSize;
+
+        if (linesPerTable > 0) {
+            const uint64_t perLine = params.mappingEntriesPerLine;
+            cycles += Metadata(swap.hotVRN / perLine, true);
+            cycles += Metadata(swap.coldVRN / perLine, true);
+            cycles += Metadata(linesPerTable + spare / perLine, true);
+            cycles += Metadata(linesPerTable + cold / perLine, true);
+            cycles += Metadata(linesPerTable + hot / perLine, true);
+        }
+
+        spare = hot;
+        return cycles;
+    }
+
+    // Start the decision on the finished epoch
+    void CloseEpoch() {
+        features.UpdateScores(params.policyParams.alpha,
+                              params.policyParams.beta,
+                              params.policyParams.decay,
+                              params.policyParams.rowHitDiscount);
+        swaps.clear();
+        if (params.decisionLatency == 0) {
+            policy->SelectSwaps(features, swaps);
+        } else {
+            snapshot = features;
+            helper.Submit([this]() { policy->SelectSwaps(snapshot, swaps); });
+        }
+
+        features.ClearCounts();
+        currentEpoch++;
+        pending = true;
+        applyAt = currentEpoch * params.epochLength + params.decisionLatency;
+    }
+
+    // Queue one migration job per swap of the decided epoch
+    void ApplyDecision() {
+        helper.Wait();
+        pending = false;
+        const bool retired = !retiring.empty();
+        if (retired) {
+            RetireRegions();
+            retiring.clear();
+        }
+        if (quotas) {
+            quotas->Filter(swaps, features.fast, features.score);
+            stats.quotaDenials = quotas->denials;
+            stats.quotaBorrows = quotas->borrows;
+            stats.quotaReclaims = quotas->reclaims;
+        }
+        if (params.matAwarePlacement && params.matGroups > 1 && swaps.size() > 1) {
+            SpreadAcrossMats();
+        }
+
+        for (const RegionSwap& swap : swaps) {
+            MigrationJob job;
+            job.groups = (1ULL << Group(PRN[swap.hotVRN]))
+                       | (1ULL << Group(PRN[swap.coldVRN]));
+            if (rotate) {
+                job.groups |= 1ULL << Group(spare);
+            }
+            uint64_t bus = 0;
+            uint64_t cycles = rotate ? Rotate(swap, bus) : Swap(swap, bus);
+            if (rotate) {
+                ReplaceWornSpare();
+            }
+            job.epoch = currentEpoch - 1;
+            job.start = 0;
+            job.cycles = static_cast<uint32_t>(cycles);
+            job.bus = static_cast<uint32_t>(bus);
+            job.rows = static_cast<uint32_t>(2 * geometry.regionSize);
+            job.moves = 2;
+            job.movedVRN[0] = static_cast<uint32_t>(swap.hotVRN);
+            job.movedPRN[0] = static_cast<uint32_t>(PRN[swap.hotVRN]);
+            job.movedVRN[1] = static_cast<uint32_t>(swap.coldVRN);
+            job.movedPRN[1] = static_cast<uint32_t>(PRN[swap.coldVRN]);
+            jobs.push_back(job);
+            stats.migrationCycles += cycles;
+            stats.migrationBusCycles += bus;
+
+            features.fast[swap.hotVRN] = IsFast(PRN[swap.hotVRN]);
+            features.fast[swap.coldVRN] = IsFast(PRN[swap.coldVRN]);
+            features.wear[swap.hotVRN] = RegionWrites(PRN[swap.hotVRN]);
+            features.wear[swap.coldVRN] = RegionWrites(PRN[swap.coldVRN]);
+        }
+        stats.migrations += swaps.size();
+        if (quotas) {
+            const std::vector<uint64_t>& held = quotas->CountHeld(features.fast);
+            for (uint64_t tenant = 0; tenant < held.size(); tenant++) {
+                stats.tenants[tenant].fastRegions += held[tenant];
+            }
+            stats.tenantDecisions++;
+        }
+        if (!swaps.empty() || retired) {
+            std::fill(openRow.begin(), openRow.end(), uint64_t(NO_ROW));
+            std::fill(lastRow.begin(), lastRow.end(), uint64_t(NO_ROW));
+            PublishMapping();
+        }
+    }
+
+    void PublishMapping() {
+        MappingSnapshot *snapshot = new MappingSnapshot();
+        snapshot->version = version++;
+        snapshot->epoch = currentEpoch;
+        snapshot->PRN = PRN;
+        mapping.Publish(snapshot);
+    }
+
+    const RegionGeometry& geometry;
+    const ReplayParams& params;
+    std::unique_ptr<MigrationPolicy> policy;
+    bool rotate;
+
+    uint64_t currentEpoch = 0;
+    RegionFeatures features;
+    std::vector<uint64_t> PRN;
+    std::vector<uint64_t> prnWrites;    // Cells written per physical region
+    uint64_t lineCells;             // Cells of an uncompressed line
+    std::vector<RegionSwap> swaps;
+    uint64_t spare;                 // Free physical region (rotate scheme)
+
+    std::vector<uint64_t> rowWrites;    // Cells written per physical row, if enabled
+    std::vector<uint32_t> failedRows;   // Per PRN
+    std::vector<uint64_t> retiring;     // Worn-out PRNs, retired at the next apply
+    std::vector<uint64_t> freeSpares;
+
+    std::unique_ptr<TenantQuotas> quotas;   // Only with TenantQuotas
+
+    bool pending = false;           // swaps not applied yet
+    uint64_t applyAt = 0;
+    RegionFeatures snapshot;        // Scores at the boundary, for the helper
+    HelperThread helper;            // Started by the first delayed decision
+
+    static const uint64_t NO_ROW = ~0ULL;
+    bool openPage;
+    bool adaptivePage;
+    std::vector<uint64_t> openRow;      // Per mat group
+    std::vector<uint64_t> lastRow;      // Last row accessed, open or not
+    std::vector<uint8_t> pageCounter;   // Adaptive policy, keep open at >= 2
+
+    MLCWriteModel mlcModel;
+
+    bool eccAll;
+    bool eccSlow;                   // Slow regions protected
+    uint64_t eccDraws = 0;          // Correction draws of this bank
+
+    std::vector<double> groupScore;     // Mat-aware placement scratch
+    std::vector<uint8_t> leaving;
+    std::vector<uint64_t> slots;
+
+    std::vector<MigrationJob> jobs;
+    uint64_t scheduled = 0;         // Jobs with a start cycle
+    uint64_t consumed = 0;          // Jobs handed to accesses
+
+    SnapshotPublisher<MappingSnapshot> mapping;
+    uint64_t version = 0;
+
+    MappingCache mappingCache;
+    uint64_t linesPerTable = 0;     // 0: mapping cache disabled
+
+    ReplayStats stats;
+};
+
+// Controller queue, data bus and bank timing of one channel
+class ChannelReplay {
+public:
+    ChannelReplay(const RegionGeometry& geometry, const ReplayParams& params)
+        : geometry(geometry), params(params),
+          groupFree(geometry.NumBanks() * params.matGroups, 0),
+          groupBusy(geometry.NumBanks() * params.matGroups, 0),
+          bankActive(geometry.NumBanks(), 0), scrubNext(geometry.NumBanks(), 0),
+          scrubPRN(geometry.NumBanks()),
+          completions(std::max<uint64_t>(params.queueSize, 1), 0) {
+        stats.tenants.resize(params.tenantQuotas.size());
+    }
+
+    // jobs are the migrations of the access's bank
+    void Access(const ReplayAccess& access, const std::vector<MigrationJob>& jobs) {
+        // The queue entry frees when the request QueueSize back completes
+        uint64_t& entry = completions[next];
+        uint64_t admit = std::max(access.cycle, entry);
+
+        const uint64_t firstGroup = access.bank * params.matGroups;
+        for (uint64_t j = access.firstJob; j < access.firstJob + access.numJobs; j++) {
+            const MigrationJob& job = jobs[j];
+            for (uint64_t group = 0; group < params.matGroups; group++) {
+                if (job.groups & (1ULL << group)) {
+                    uint64_t& free = groupFree[firstGroup + group];
+                    free = std::max(free, job.start) + job.cycles;
+                    Busy(access.bank, firstGroup + group, free - job.cycles, free);
+                }
+            }
+            if (params.scrubInterval > 0) {
+                std::vector<uint32_t>& prns = DataPRNs(access.bank);
+                for (uint32_t move = 0; move < job.moves; move++) {
+                    prns[job.movedVRN[move]] = job.movedPRN[move];
+                }
+            }
+        }
+
+        // Migration transfers hold the bus from their start, whichever
+        // bank the channel is serving then
+        while (nextTransfer < transfers.size()
+               && transfers[nextTransfer].start <= access.cycle) {
+            const MigrationJob& transfer = transfers[nextTransfer++];
+            busFree = std::max(busFree, transfer.start) + transfer.bus;
+        }
+        if (nextTransfer == transfers.size()) {
+            transfers.clear();
+            nextTransfer = 0;
+        }
+
+        uint64_t& group = groupFree[firstGroup + access.group];
+        if (params.scrubInterval > 0) {
+            uint64_t before = std::max(group, admit);
+            Scrub(access.bank, admit);
+            stats.scrubDelay += std::max(group, admit) - before;
+        }
+        uint64_t start = std::max(admit, group);
+        uint64_t ready = start + access.service;
+        uint64_t busStart = std::max(ready, busFree);
+        uint64_t complete = busStart + params.burstCycles;
+
+        group = ready;
+        Busy(access.bank, firstGroup + access.group, start, ready);
+        busFree = complete;
+        entry = complete;
+        next = (next + 1 == completions.size()) ? 0 : next + 1;
+
+        stats.totalLatency += complete - access.cycle;
+        if (!stats.tenants.empty()) {
+            stats.tenants[access.tenant].totalLatency += complete - access.cycle;
+        }
+        stats.queueCycles += admit - access.cycle;
+        stats.bankCycles += start - admit;
+        stats.busCycles += busStart - ready;
+        stats.lastCompletion = std::max(stats.lastCompletion, complete);
+    }
+
+    // Queue the bus transfers of a scheduled migration. The scheduler
+    // starts migrations in start cycle order.
+    void Transfer(const MigrationJob& job) {
+        transfers.push_back(job);
+    }
+
+    const ReplayStats& Stats() const {
+        return stats;
+    }
+
+private:
+    // Where the scrubs find the data of each VRN of bank, identity until
+    // the bank's first migration
+    std::vector<uint32_t>& DataPRNs(uint64_t bank) {
+        std::vector<uint32_t>& prns = scrubPRN[bank];
+        if (prns.empty()) {
+            prns.resize(geometry.RegionsPerBank());
+            for (uint64_t VRN = 0; VRN < prns.size(); VRN++) {
+                prns[VRN] = static_cast<uint32_t>(VRN);
+            }
+        }
+        return prns;
+    }
+
+    // Issue the scrubs of bank released by now, in row order
+    void Scrub(uint64_t bank, uint64_t now) {
+        const uint64_t regions = geometry.RegionsPerBank();
+        const uint64_t rows = regions * geometry.regionSize;
+        const uint64_t deadline = params.scrubDeadline > 0
+                                ? params.scrubDeadline : params.scrubInterval;
+        const uint64_t firstGroup = bank * params.matGroups;
+        uint64_t& index = scrubNext[bank];
+
+        while (true) {
+            const uint64_t pass = index / rows;
+            const uint64_t row = index % rows;
+            const uint64_t release = pass * params.scrubInterval
+                                   + row * params.scrubInterval / rows;
+            if (release > now) {
+                break;
+            }
+
+            const uint64_t prn = DataPRNs(bank)[row / geometry.regionSize];
+            const bool fast = prn < regions && geometry.IsFastPRN(prn);
+            if (fast && pass % params.scrubFastPasses != 0) {
+                index++;
+                continue;
+            }
+
+            const uint64_t cycles = fast ? params.fastScrubLatency
+                                         : params.slowScrubLatency;
+            const uint64_t group = firstGroup + geometry.MatOfPRN(prn) % params.matGroups;
+            uint64_t& free = groupFree[group];
+            const uint64_t start = std::max(free, release);
+            if (start + cycles > now) {
+                // No idle time left before now, wait unless overdue
+                if (release + deadline > now) {
+                    break;
+                }
+                stats.scrubEscalations++;
+            }
+
+            free = start + cycles;
+            Busy(bank, group, start, free);
+            stats.scrubRows++;
+            stats.scrubCycles += cycles;
+            index++;
+        }
+    }
+
+    // Account [from, to) of a mat group. Bank activity is the union of
+    // the busy intervals, swept in arrival order.
+    void Busy(uint64_t bank, uint64_t group, uint64_t from, uint64_t to) {
+        groupBusy[group] += to - from;
+        stats.matBusyCycles += to - from;
+        stats.matBusyMax = std::max(stats.matBusyMax, groupBusy[group]);
+
+        uint64_t& active = bankActive[bank];
+        if (to > active) {
+            stats.bankActiveCycles += to - std::max(from, active);
+            active = to;
+        }
+    }
+
+    const RegionGeometry& geometry;
+    const ReplayParams& params;
+    std::vector<uint64_t> groupFree;    // Indexed by global bank, mat group
+    std::vector<uint64_t> groupBusy;
+    std::vector<uint64_t> bankActive;   // End of the bank's busy time
+    std::vector<uint64_t> scrubNext;    // Next scrub of each bank, by pass and row
+    std::vector<std::vector<uint32_t>> scrubPRN;    // Per bank, by VRN
+    std::vector<uint64_t> completions;  // Ring of the last QueueSize completions
+    uint64_t next = 0;
+    uint64_t busFree = 0;
+    std::vector<MigrationJob> transfers;    // Controller copies, by start
+    uint64_t nextTransfer = 0;
+
+    ReplayStats stats;
+};
+
+/*
+ * Starts the migrations of closed epochs in epoch order. Within an epoch
+ * the banks take turns, one migration at a time, beginning with bank
+ * epoch % NumBanks, and each migration waits for one token per row.
+ */
+class MigrationScheduler {
+public:
+    explicit MigrationScheduler(const ReplayParams& params) : params(params) {}
+
+    // Schedule every epoch before epoch, all banks must have applied them.
+    // Bus transfers go to the channel of their bank.
+    void Schedule(std::vector<std::unique_ptr<BankReplay>>& banks,
+                  std::vector<std::unique_ptr<ChannelReplay>>& channels, uint64_t epoch) {
+        const uint64_t numBanks = banks.size();
+        const uint64_t banksPerChannel = numBanks / channels.size();
+        const uint64_t tolerance = params.migrationTokenBurst * params.migrationTokenCycles;
+
+        for (; nextEpoch < epoch; nextEpoch++) {
+            const uint64_t boundary = (nextEpoch + 1) * params.epochLength
+                                    + params.decisionLatency;
+            bool pending = true;
+            while (pending) {
+                pending = false;
+                for (uint64_t i = 0; i < numBanks; i++) {
+                    const uint64_t index = (nextEpoch + i) % numBanks;
+                    MigrationJob *job = banks[index]->NextUnscheduled(nextEpoch);
+                    if (!job) {
+                        continue;
+                    }
+                    pending = true;
+
+                    // Virtual scheduling: tokenTime is when the bucket
+                    // would be full again. The job starts once all of its
+                    // tokens are in the bucket; a job larger than the
+                    // bucket waits for a full one.
+                    const uint64_t cost = job->rows * params.migrationTokenCycles;
+                    const uint64_t ready = tokenTime + std::min(cost, tolerance);
+                    uint64_t start = boundary;
+                    if (ready > tolerance) {
+                        start = std::max(start, ready - tolerance);
+                    }
+                    tokenTime = std::max(start, tokenTime) + cost;
+                    job->start = start;
+                    stats.migrationDelay += start - boundary;
+                    if (job->bus > 0) {
+                        channels[index / banksPerChannel]->Transfer(*job);
+                    }
+                }
+            }
+        }
+    }
+
+    const ReplayStats& Stats() const {
+        return stats;
+    }
+
+private:
+    const ReplayParams& params;
+    uint64_t nextEpoch = 0;
+    uint64_t tokenTime = 0;
+
+    ReplayStats stats;
+};
+
+// Runs a function on a fixed set of threads and waits for all of them
+class WorkerPool {
+public:
+    explicit WorkerPool(uint64_t numThreads) : numThreads(std::max<uint64_t>(numThreads, 1)) {
+        for (uint64_t id = 1; id < this->numThreads; id++) {
+            threads.emplace_back(&WorkerPool::Run, this, id);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        start.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Call task(id) for id = 0 .. Size() - 1, id 0 on the calling thread
+    void Execute(const std::function<void(uint64_t)>& task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->task = &task;
+            pending = numThreads - 1;
+            generation++;
+        }
+        start.notify_all();
+
+        task(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    uint64_t Size() const {
+        return numThreads;
+    }
+
+private:
+    void Run(uint64_t id) {
+        uint64_t seen = 0;
+        while (true) {
+            const std::function<void(uint64_t)> *current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                current = task;
+            }
+
+            (*current)(id);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    uint64_t numThreads;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    const std::function<void(uint64_t)> *task = nullptr;
+    uint64_t pending = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+class ReplayEngine {
+public:
+    ReplayEngine(const RegionGeometry& geometry, const ReplayParams& params,
+                 uint64_t numThreads)
+        : geometry(geometry), params(params), pool(numThreads), scheduler(params) {
+        for (uint64_t bank = 0; bank < geometry.NumBanks(); bank++) {
+            banks.emplace_back(new BankReplay(bank, geometry, params, snapshots));
+        }
+        for (uint64_t channel = 0; channel < geometry.channels; channel++) {
+            channels.emplace_back(new ChannelReplay(geometry, params));
+        }
+    }
+
+    // Replay one block of requests in trace order
+    void Replay(const TraceRequest *requests, uint64_t count) {
+        const uint64_t numThreads = pool.Size();
+        accesses.resize(count);
+
+        // Decode, split into contiguous slices
+        lastCycles.assign(numThreads, 0);
+        pool.Execute([&](uint64_t id) {
+            uint64_t begin = count * id / numThreads;
+            uint64_t end = count * (id + 1) / numThreads;
+            for (uint64_t i = begin; i < end; i++) {
+                lastCycles[id] = std::max(lastCycles[id], requests[i].cycle);
+                RegionLocation location = geometry.Decode(requests[i].address);
+                ReplayAccess& access = accesses[i];
+                access.cycle = requests[i].cycle;
+                access.bank = static_cast<uint32_t>(location.globalBank);
+                access.VRN = static_cast<uint32_t>(location.VRN);
+                access.row = static_cast<uint32_t>(location.row);
+                access.channel = static_cast<uint16_t>(location.channel);
+                access.op = requests[i].op;
+                access.data = requests[i].dataHash ? requests[i].dataHash
+                                                   : requests[i].address;
+                access.lineBytes = requests[i].lineBytes;
+                access.tenant = TenantOf(params, requests[i].requestor);
+            }
+        });
+
+        for (uint64_t cycle : lastCycles) {
+            lastCycle = std::max(lastCycle, cycle);
+        }
+
+        // Bank phase, thread id owns banks id, id + numThreads, ...
+        pool.Execute([&](uint64_t id) {
+            for (uint64_t bank = id; bank < banks.size(); bank += numThreads) {
+                banks[bank]->Trim();
+            }
+            for (uint64_t i = 0; i < count; i++) {
+                ReplayAccess& access = accesses[i];
+                if (access.bank % numThreads == id) {
+                    banks[access.bank]->Access(access);
+                }
+            }
+            for (uint64_t bank = id; bank < banks.size(); bank += numThreads) {
+                banks[bank]->AdvanceTo(lastCycle);
+            }
+        });
+
+        scheduler.Schedule(banks, channels, AppliedEpochs(params, lastCycle));
+
+        // Channel phase, thread id owns channels id, id + numThreads, ...
+        pool.Execute([&](uint64_t id) {
+            if (id >= channels.size()) {
+                return;
+            }
+            for (uint64_t i = 0; i < count; i++) {
+                const ReplayAccess& access = accesses[i];
+                if (access.channel % numThreads == id) {
+                    channels[access.channel]->Access(access,
+                                                     banks[access.bank]->Jobs());
+                }
+            }
+        });
+    }
+
+    // Bank statistics summed in bank order, channel timing in channel order
+    ReplayStats Stats() const {
+        ReplayStats stats;
+        for (const auto& bank : banks) {
+            stats.Add(bank->Stats());
+        }
+        for (const auto& channel : channels) {
+            stats.Add(channel->Stats());
+        }
+        stats.Add(scheduler.Stats());
+        return stats;
+    }
+
+    // Readers register here to read Mapping() concurrently with Replay()
+    SnapshotDomain& Snapshots() {
+        return snapshots;
+    }
+
+    const SnapshotPublisher<MappingSnapshot>& Mapping(uint64_t bank) const {
+        return banks[bank]->Mapping();
+    }
+
+private:
+    const RegionGeometry& geometry;
+    const ReplayParams& params;
+    WorkerPool pool;
+
+    SnapshotDomain snapshots;
+    std::vector<std::unique_ptr<BankReplay>> banks;
+    std::vector<std::unique_ptr<ChannelReplay>> channels;
+    MigrationScheduler scheduler;
+    std::vector<ReplayAccess> accesses;
+    std::vector<uint64_t> lastCycles;   // Per decode slice
+    uint64_t lastCycle = 0;             // Every bank has caught up to it
+};
+
+/*
+ * Reference replay: the same model, one request at a time through both
+ * phases, in trace order.
+ */
+class ReplaySerial {
+public:
+    ReplaySerial(const RegionGeometry& geometry, const ReplayParams& params)
+        : geometry(geometry), params(params), scheduler(params) {
+        for (uint64_t bank = 0; bank < geometry.NumBanks(); bank++) {
+            banks.emplace_back(new BankReplay(bank, geometry, params, snapshots));
+        }
+        for (uint64_t channel = 0; channel < geometry.channels; channel++) {
+            channels.emplace_back(new ChannelReplay(geometry, params));
+        }
+    }
+
+    void Replay(const TraceRequest *requests, uint64_t count) {
+        for (uint64_t i = 0; i < count; i++) {
+            RegionLocation location = geometry.Decode(requests[i].address);
+            ReplayAccess access;
+            access.cycle = requests[i].cycle;
+            access.bank = static_cast<uint32_t>(location.globalBank);
+            access.VRN = static_cast<uint32_t>(location.VRN);
+            access.row = static_cast<uint32_t>(location.row);
+            access.channel = static_cast<uint16_t>(location.channel);
+            access.op = requests[i].op;
+            access.data = requests[i].dataHash ? requests[i].dataHash
+                                               : requests[i].address;
+            access.lineBytes = requests[i].lineBytes;
+            access.tenant = TenantOf(params, requests[i].requestor);
+
+            // Catch every bank up at boundaries and apply cycles
+            uint64_t epoch = access.cycle / params.epochLength;
+            uint64_t applied = AppliedEpochs(params, access.cycle);
+            if (epoch > closedEpochs || applied > appliedEpochs) {
+                closedEpochs = std::max(closedEpochs, epoch);
+                appliedEpochs = std::max(appliedEpochs, applied);
+                for (auto& bank : banks) {
+                    bank->AdvanceTo(access.cycle);
+                }
+                scheduler.Schedule(banks, channels, appliedEpochs);
+            }
+
+            BankReplay& bank = *banks[access.bank];
+            bank.Trim();
+            bank.Access(access);
+            channels[access.channel]->Access(access, bank.Jobs());
+        }
+    }
+
+    ReplayStats Stats() const {
+        ReplayStats stats;
+        for (const auto& bank : banks) {
+            stats.Add(bank->Stats());
+        }
+        for (const auto& channel : channels) {
+            stats.Add(channel->Stats());
+        }
+        stats.Add(scheduler.Stats());
+        return stats;
+    }
+
+    // Readers register here to read Mapping() concurrently with Replay()
+    SnapshotDomain& Snapshots() {
+        return snapshots;
+    }
+
+    const SnapshotPublisher<MappingSnapshot>& Mapping(uint64_t bank) const {
+        return banks[bank]->Mapping();
+    }
+
+private:
+    const RegionGeometry& geometry;
+    const ReplayParams& params;
+    SnapshotDomain snapshots;
+    std::vector<std::unique_ptr<BankReplay>> banks;
+    std::vector<std::unique_ptr<ChannelReplay>> channels;
+    MigrationScheduler scheduler;
+    uint64_t closedEpochs = 0;
+    uint64_t appliedEpochs = 0;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * Per-Tenant Fast-Region Quotas
+ *
+ * Partitions the fast regions of a bank between tenants, so that one
+ * aggressive workload cannot claim every fast slot and the critical
+ * service keeps its share. A tenant is a requestor ID (each gem5 core
+ * issues requests under its own); requestors past the last quota share the
+ * last tenant. A region belongs to the tenant that accessed it last.
+ *
+ * Filter takes the swap list of an epoch, each swap moving a hot region
+ * into the fast slot of a cold one, and drops or redirects the swaps that
+ * break a quota:
+ * - a swap that promotes a region of a tenant already at its quota is
+ *   dropped;
+ * - a swap may not demote a region of another tenant within its quota:
+ *   the coldest fast region held past a quota (or by no tenant) is demoted
+ *   in its place if it is colder than the hot region, otherwise the swap
+ *   is dropped;
+ * - a tenant below its quota also demotes such a region before one of its
+ *   own.
+ * With borrowing a tenant may exceed its quota while fast regions are left
+ * to spare; the regions it holds over its quota are the first ones taken
+ * back.
+ *
+ * One TenantQuotas tracks one bank. Filter works on any swap type with
+ * hotVRN and coldVRN members.
+ */
+
+#ifndef __TOOLS_TENANT_QUOTA_H__
+#define __TOOLS_TENANT_QUOTA_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Tenant of a requestor, the last tenant takes the remaining requestors
+inline uint32_t RequestorTenant(uint64_t tenants, uint16_t requestor) {
+    return static_cast<uint32_t>(std::min<uint64_t>(requestor, tenants - 1));
+}
+
+class TenantQuotas {
+public:
+    // Owner of a region no tenant has accessed; tenants come from 16-bit
+    // requestor IDs, so no tenant index reaches it
+    static const uint32_t NO_TENANT = ~0u;
+
+    uint64_t denials = 0;   // Swaps dropped for a quota
+    uint64_t borrows = 0;   // Promotions past the tenant's quota
+    uint64_t reclaims = 0;  // Demotions of regions held past a quota
+
+    // Fast regions per bank for each tenant, for a bank of regions regions
+    TenantQuotas(const std::vector<uint64_t>& quotas, bool borrowing, uint64_t regions)
+        : quotas(quotas), borrowing(borrowing), owner(regions, NO_TENANT),
+          held(quotas.size(), 0) {}
+
+    uint64_t Tenants() const {
+        return quotas.size();
+    }
+
+    void Access(uint64_t VRN, uint32_t tenant) {
+        owner[VRN] = tenant;
+    }
+
+    uint32_t Owner(uint64_t VRN) const {
+        return owner[VRN];
+    }
+
+    // Fast regions held by each tenant
+    const std::vector<uint64_t>& CountHeld(const std::vector<uint8_t>& fast) {
+        std::fill(held.begin(), held.end(), 0);
+        for (uint64_t VRN = 0; VRN < owner.size(); VRN++) {
+            if (fast[VRN] && owner[VRN] != NO_TENANT) {
+                held[owner[VRN]]++;
+            }
+        }
+        return held;
+    }
+
+    // Drop or redirect the swaps that break a tenant's fast-region quota
+    template <typename Swap>
+    void Filter(std::vector<Swap>& swaps, const std::vector<uint8_t>& fast,
+                const std::vector<double>& score) {
+        CountHeld(fast);
+        inSwap.assign(owner.size(), 0);
+        for (const Swap& swap : swaps) {
+            inSwap[swap.hotVRN] = 1;
+            inSwap[swap.coldVRN] = 1;
+        }
+
+        uint64_t kept = 0;
+        for (Swap swap : swaps) {
+            const uint32_t hot = owner[swap.hotVRN];
+            uint32_t cold = owner[swap.coldVRN];
+
+            // Another tenant's region within its quota stays fast, and a
+            // tenant below its quota takes back borrowed regions first
+            const bool below = hot != NO_TENANT && held[hot] < quotas[hot];
+            if (cold != NO_TENANT && !OverQuota(cold) && (cold != hot || below)) {
+                uint64_t victim = Victim(fast, score, score[swap.hotVRN]);
+                if (victim != owner.size()) {
+                    swap.coldVRN = victim;
+                    inSwap[victim] = 1;
+                    cold = owner[victim];
+                } else if (cold != hot) {
+                    denials++;
+                    continue;
+                }
+            }
+
+            if (hot != NO_TENANT && hot != cold && held[hot] >= quotas[hot]) {
+                if (!borrowing) {
+                    denials++;
+                    continue;
+                }
+                borrows++;
+            }
+            if (cold != hot && OverQuota(cold)) {
+                reclaims++;
+            }
+
+            if (hot != NO_TENANT) {
+                held[hot]++;
+            }
+            if (cold != NO_TENANT) {
+                held[cold]--;
+            }
+            swaps[kept++] = swap;
+        }
+        swaps.resize(kept);
+    }
+
+private:
+    bool OverQuota(uint32_t tenant) const {
+        return tenant != NO_TENANT && held[tenant] > quotas[tenant];
+    }
+
+    /*
+     * The coldest fast region outside the swap list that may be demoted
+     * for a region of score hot: one held past a quota or by no tenant.
+     * The number of regions if there is none.
+     */
+    uint64_t Victim(const std::vector<uint8_t>& fast, const std::vector<double>& score,
+                    double hot) const {
+        uint64_t victim = owner.size();
+        for (uint64_t VRN = 0; VRN < owner.size(); VRN++) {
+            if (!fast[VRN] || inSwap[VRN] || score[VRN] >= hot
+                || (owner[VRN] != NO_TENANT && !OverQuota(owner[VRN]))) {
+                continue;
+            }
+            if (victim == owner.size() || score[VRN] < score[victim]) {
+                victim = VRN;
+            }
+        }
+        return victim;
+    }
+
+    std::vector<uint64_t> quotas;
+    bool borrowing;
+    std::vector<uint32_t> owner;    // Tenant that last accessed each VRN
+    std::vector<uint64_t> held;     // Fast regions per tenant
+    std::vector<uint8_t> inSwap;
+};
+
+#endif
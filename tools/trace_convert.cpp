@@ -0,0 +1,157 @@
+/**
+ * Trace Converter
+ *
+ * Converts an NVMain text trace (printtrace) into the binary request trace
+ * format of tools/trace_format.h, so a run is captured once and replayed
+ * by the analysis tools many times. With --info, prints the header and
+ * chunk index of an existing binary trace instead. --line-bytes stores the
+ * compressed size of each line (tools/line_compression.h), computed from
+ * the trace's data field.
+ *
+ * Usage:
+ *   trace_convert --trace <trace.nvt> --output <trace.nvmt>
+ *                 [--data-hash] [--line-bytes] [--chunk-records N]
+ *   trace_convert --info <trace.nvmt>
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "trace_format.h"
+#include "trace_request.h"
+
+static void PrintUsage() {
+    std::cout << "Usage: trace_convert --trace <trace.nvt> "
+              << "--output <trace.nvmt>" << std::endl
+              << "                     [--data-hash] [--line-bytes] [--chunk-records N]"
+              << std::endl
+              << "       trace_convert --info <trace.nvmt>" << std::endl;
+}
+
+static int PrintInfo(const std::string& path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Error: cannot open trace " << path << std::endl;
+        return 1;
+    }
+
+    FileHeader header;
+    FileFooter footer;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1
+              && std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0
+              && SupportedHeader(header)
+              && std::fseek(file, -static_cast<long>(sizeof(footer)), SEEK_END) == 0
+              && std::fread(&footer, sizeof(footer), 1, file) == 1
+              && std::memcmp(footer.magic, TRACE_INDEX_MAGIC, sizeof(footer.magic)) == 0;
+
+    std::vector<IndexEntry> index(valid ? footer.numChunks : 0);
+    if (valid && !index.empty()) {
+        valid = std::fseek(file, static_cast<long>(footer.indexOffset), SEEK_SET) == 0
+             && std::fread(index.data(), sizeof(IndexEntry), index.size(), file)
+                == index.size();
+    }
+    std::fclose(file);
+
+    if (!valid) {
+        std::cerr << "Error: " << path << " is not a complete binary trace "
+                  << "of a supported version" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Version:        " << header.version << std::endl;
+    std::cout << "Data hashes:    " << ((header.flags & FILE_DATA_HASH) ? "yes" : "no")
+              << std::endl;
+    std::cout << "Line bytes:     " << ((header.flags & FILE_LINE_BYTES) ? "yes" : "no")
+              << std::endl;
+    std::cout << "Records:        " << footer.numRecords << std::endl;
+    std::cout << "Chunks:         " << footer.numChunks << " x "
+              << header.chunkRecords << " records" << std::endl;
+    if (footer.numRecords > 0) {
+        std::cout << "Bytes/record:   "
+                  << static_cast<double>(footer.indexOffset) / footer.numRecords
+                  << std::endl;
+        std::cout << "Ticks:          " << index.front().firstTick << " - "
+                  << index.back().lastTick << std::endl;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    std::string traceFile, outputFile, infoFile;
+    bool dataHash = false, lineBytes = false;
+    uint32_t chunkRecords = 1 << 16;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--data-hash") {
+            dataHash = true;
+            continue;
+        }
+        if (arg == "--line-bytes") {
+            lineBytes = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 1;
+        }
+
+        if (arg == "--trace") {
+            traceFile = argv[++i];
+        } else if (arg == "--output") {
+            outputFile = argv[++i];
+        } else if (arg == "--info") {
+            infoFile = argv[++i];
+        } else if (arg == "--chunk-records") {
+            chunkRecords = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (!infoFile.empty()) {
+        return PrintInfo(infoFile);
+    }
+
+    if (traceFile.empty() || outputFile.empty() || chunkRecords == 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::ifstream trace(traceFile);
+    if (!trace.is_open()) {
+        std::cerr << "Error: cannot open trace " << traceFile << std::endl;
+        return 1;
+    }
+
+    TraceWriter writer;
+    if (!writer.Open(outputFile, dataHash, chunkRecords, lineBytes)) {
+        std::cerr << "Error: cannot create " << outputFile << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    TraceRequest request;
+    uint64_t numRequests = 0;
+    while (std::getline(trace, line)) {
+        if (ParseNVMainTraceLine(line, request)) {
+            writer.Record(request);
+            numRequests++;
+        }
+    }
+    if (!writer.Close()) {
+        std::cerr << "Error: cannot write " << outputFile << std::endl;
+        return 1;
+    }
+
+    std::cout << "Converted " << numRequests << " requests to " << outputFile
+              << std::endl;
+    return 0;
+}
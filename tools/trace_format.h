@@ -0,0 +1,469 @@
+/**
+ * Binary Request Trace Format
+ *
+ * Compact, replayable record of the requests that reach NVMainMemory:
+ * (tick, address, read/write, size, requestor, optional data hash and
+ * compressed line size).
+ *
+ * File layout (all integers little endian):
+ *   FileHeader
+ *   Chunk 0 .. Chunk N-1      - independently decodable
+ *   IndexEntry[N]             - one per chunk, for random seek
+ *   FileFooter                - locates the index
+ *
+ * Chunk: ChunkHeader followed by payloadBytes of records. Records are
+ * delta encoded against the previous record of the same chunk (the first
+ * against tick 0 / address 0 / size 64 / requestor 0):
+ *   uint8  flags              - RECORD_WRITE, RECORD_SIZE, RECORD_REQUESTOR
+ *   varint zigzag(tick delta)
+ *   varint zigzag(address delta)
+ *   varint size               - only if RECORD_SIZE
+ *   varint requestor          - only if RECORD_REQUESTOR
+ *   uint64 data hash          - only if the file has FILE_DATA_HASH
+ *   uint8  line bytes         - only if the file has FILE_LINE_BYTES
+ *
+ * TraceWriter is meant to be driven from the simulation thread: Record()
+ * only pushes the request into a lock-free single-producer/single-consumer
+ * ring, and a background thread encodes and writes the chunks. When the
+ * ring is full the producer waits; requests are never dropped.
+ */
+
+#ifndef __TOOLS_TRACE_FORMAT_H__
+#define __TOOLS_TRACE_FORMAT_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace_request.h"
+
+static const char TRACE_MAGIC[8] = {'N', 'V', 'M', 'T', 'R', 'C', '0', '1'};
+static const char TRACE_INDEX_MAGIC[8] = {'N', 'V', 'M', 'T', 'I', 'D', 'X', '1'};
+static const uint32_t TRACE_VERSION = 2;  // 2: FILE_LINE_BYTES
+
+enum TraceFileFlags : uint32_t {
+    FILE_DATA_HASH = 1 << 0,
+    FILE_LINE_BYTES = 1 << 1
+};
+
+enum TraceRecordFlags : uint8_t {
+    RECORD_WRITE = 1 << 0,
+    RECORD_SIZE = 1 << 1,
+    RECORD_REQUESTOR = 1 << 2
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t chunkRecords;  // Records per chunk, the last may hold fewer
+    uint32_t reserved;
+};
+
+struct ChunkHeader {
+    uint32_t numRecords;
+    uint32_t payloadBytes;
+};
+
+struct IndexEntry {
+    uint64_t offset;        // File offset of the ChunkHeader
+    uint64_t firstRecord;
+    uint64_t firstTick;
+    uint64_t lastTick;
+};
+
+struct FileFooter {
+    uint64_t indexOffset;
+    uint64_t numChunks;
+    uint64_t numRecords;
+    char magic[8];
+};
+
+// File flags change the record layout, so a reader rejects any it does not know
+inline bool SupportedHeader(const FileHeader& header) {
+    uint32_t known = FILE_DATA_HASH;
+    if (header.version >= 2) {
+        known |= FILE_LINE_BYTES;
+    }
+    return header.version >= 1 && header.version <= TRACE_VERSION
+        && (header.flags & ~known) == 0;
+}
+
+inline void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Returns the byte after the varint, or nullptr if it runs past end
+inline const uint8_t *GetVarint(const uint8_t *in, const uint8_t *end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (in >= end) {
+            return nullptr;
+        }
+        uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return in;
+}
+
+inline uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Encodes the records of one chunk
+class ChunkEncoder {
+public:
+    explicit ChunkEncoder(bool dataHash, bool lineBytes = false)
+        : dataHash(dataHash), lineBytes(lineBytes) {
+        Reset();
+    }
+
+    void Reset() {
+        payload.clear();
+        numRecords = 0;
+        previous.cycle = 0;
+        previous.address = 0;
+        previous.size = 64;
+        previous.requestor = 0;
+    }
+
+    void Add(const TraceRequest& request) {
+        uint8_t flags = 0;
+        if (request.op == TRACE_WRITE) {
+            flags |= RECORD_WRITE;
+        }
+        if (request.size != previous.size) {
+            flags |= RECORD_SIZE;
+        }
+        if (request.requestor != previous.requestor) {
+            flags |= RECORD_REQUESTOR;
+        }
+
+        payload.push_back(flags);
+        PutVarint(payload, ZigZag(static_cast<int64_t>(request.cycle - previous.cycle)));
+        PutVarint(payload, ZigZag(static_cast<int64_t>(request.address - previous.address)));
+        if (flags & RECORD_SIZE) {
+            PutVarint(payload, request.size);
+        }
+        if (flags & RECORD_REQUESTOR) {
+            PutVarint(payload, request.requestor);
+        }
+        if (dataHash) {
+            const uint8_t *hash = reinterpret_cast<const uint8_t *>(&request.dataHash);
+            payload.insert(payload.end(), hash, hash + sizeof(uint64_t));
+        }
+        if (lineBytes) {
+            payload.push_back(request.lineBytes);
+        }
+
+        if (numRecords == 0) {
+            firstTick = request.cycle;
+        }
+        lastTick = request.cycle;
+        previous = request;
+        numRecords++;
+    }
+
+    bool dataHash;
+    bool lineBytes;
+    std::vector<uint8_t> payload;
+    uint32_t numRecords;
+    uint64_t firstTick;
+    uint64_t lastTick;
+
+private:
+    TraceRequest previous;
+};
+
+/*
+ * Decode the payload of one chunk into requests, which must hold
+ * header.numRecords entries. Returns false if the payload is truncated,
+ * without reading past its end.
+ */
+inline bool DecodeChunk(const uint8_t *payload, const ChunkHeader& header,
+                        bool dataHash, TraceRequest *requests,
+                        bool lineBytes = false) {
+    const uint8_t *in = payload;
+    const uint8_t *end = payload + header.payloadBytes;
+    uint64_t tick = 0, address = 0, value;
+    uint32_t size = 64;
+    uint16_t requestor = 0;
+    const uint64_t fixedBytes = (dataHash ? sizeof(uint64_t) : 0) + (lineBytes ? 1 : 0);
+
+    for (uint32_t i = 0; i < header.numRecords; i++) {
+        if (in >= end) {
+            return false;
+        }
+
+        uint8_t flags = *in++;
+        in = GetVarint(in, end, value);
+        if (!in) {
+            return false;
+        }
+        tick += UnZigZag(value);
+        in = GetVarint(in, end, value);
+        if (!in) {
+            return false;
+        }
+        address += UnZigZag(value);
+        if (flags & RECORD_SIZE) {
+            in = GetVarint(in, end, value);
+            if (!in) {
+                return false;
+            }
+            size = static_cast<uint32_t>(value);
+        }
+        if (flags & RECORD_REQUESTOR) {
+            in = GetVarint(in, end, value);
+            if (!in) {
+                return false;
+            }
+            requestor = static_cast<uint16_t>(value);
+        }
+        if (static_cast<uint64_t>(end - in) < fixedBytes) {
+            return false;
+        }
+
+        TraceRequest& request = requests[i];
+        request.cycle = tick;
+        request.address = address;
+        request.size = size;
+        request.requestor = requestor;
+        request.op = (flags & RECORD_WRITE) ? TRACE_WRITE : TRACE_READ;
+        request.lineBytes = 0;
+        request.dataHash = 0;
+        if (dataHash) {
+            std::memcpy(&request.dataHash, in, sizeof(uint64_t));
+            in += sizeof(uint64_t);
+        }
+        if (lineBytes) {
+            request.lineBytes = *in++;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Lock-free ring between exactly one producer and one consumer thread.
+ * Capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SPSCRing {
+public:
+    explicit SPSCRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool TryPush(const T& item) {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head - cachedTail > mask) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (head - cachedTail > mask) {
+                return false;
+            }
+        }
+        slots[head & mask] = item;
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item) {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail == cachedHead) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (tail == cachedHead) {
+                return false;
+            }
+        }
+        item = slots[tail & mask];
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+
+    // Producer and consumer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+};
+
+class TraceWriter {
+public:
+    TraceWriter() : ring(1 << 16), encoder(false) {}
+
+    ~TraceWriter() {
+        Close();
+    }
+
+    /*
+     * Create the trace file and start the writer thread. Returns false if
+     * the file cannot be created or its header cannot be written.
+     */
+    bool Open(const std::string& path, bool dataHash,
+              uint32_t chunkRecords = 1 << 16, bool lineBytes = false) {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+
+        FileHeader header;
+        std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+        header.version = TRACE_VERSION;
+        header.flags = (dataHash ? static_cast<uint32_t>(FILE_DATA_HASH) : 0)
+                     | (lineBytes ? static_cast<uint32_t>(FILE_LINE_BYTES) : 0);
+        header.chunkRecords = chunkRecords;
+        header.reserved = 0;
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            std::fclose(file);
+            file = nullptr;
+            return false;
+        }
+
+        failed = false;
+        this->chunkRecords = chunkRecords;
+        offset = sizeof(header);
+        encoder.dataHash = dataHash;
+        encoder.lineBytes = lineBytes;
+        encoder.Reset();
+        index.clear();
+        numRecords = 0;
+        done.store(false);
+        thread = std::thread(&TraceWriter::Run, this);
+        return true;
+    }
+
+    // Called by the simulation thread for every request
+    void Record(const TraceRequest& request) {
+        while (!ring.TryPush(request)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /*
+     * Flush all recorded requests and write the index. Returns false if the
+     * trace was not open or any write to it failed (e.g. a full disk), in
+     * which case the file is incomplete.
+     */
+    bool Close() {
+        if (!file) {
+            return false;
+        }
+
+        done.store(true, std::memory_order_release);
+        thread.join();
+
+        if (encoder.numRecords > 0) {
+            WriteChunk();
+        }
+
+        FileFooter footer;
+        footer.indexOffset = offset;
+        footer.numChunks = index.size();
+        footer.numRecords = numRecords;
+        std::memcpy(footer.magic, TRACE_INDEX_MAGIC, sizeof(footer.magic));
+        if (!index.empty()) {
+            Write(index.data(), sizeof(IndexEntry) * index.size());
+        }
+        Write(&footer, sizeof(footer));
+
+        if (std::fclose(file) != 0) {
+            failed = true;
+        }
+        file = nullptr;
+        return !failed;
+    }
+
+private:
+    void Run() {
+        TraceRequest request;
+        int idle = 0;
+
+        while (true) {
+            if (ring.TryPop(request)) {
+                encoder.Add(request);
+                if (encoder.numRecords == chunkRecords) {
+                    WriteChunk();
+                }
+                idle = 0;
+            } else if (done.load(std::memory_order_acquire)) {
+                // The producer stopped before setting done, drain the rest
+                while (ring.TryPop(request)) {
+                    encoder.Add(request);
+                    if (encoder.numRecords == chunkRecords) {
+                        WriteChunk();
+                    }
+                }
+                break;
+            } else if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    void WriteChunk() {
+        IndexEntry entry;
+        entry.offset = offset;
+        entry.firstRecord = numRecords;
+        entry.firstTick = encoder.firstTick;
+        entry.lastTick = encoder.lastTick;
+        index.push_back(entry);
+
+        ChunkHeader header;
+        header.numRecords = encoder.numRecords;
+        header.payloadBytes = static_cast<uint32_t>(encoder.payload.size());
+        Write(&header, sizeof(header));
+        Write(encoder.payload.data(), encoder.payload.size());
+
+        offset += sizeof(header) + encoder.payload.size();
+        numRecords += encoder.numRecords;
+        encoder.Reset();
+    }
+
+    void Write(const void *data, size_t bytes) {
+        if (std::fwrite(data, 1, bytes, file) != bytes) {
+            failed = true;
+        }
+    }
+
+    SPSCRing<TraceRequest> ring;
+    ChunkEncoder encoder;
+    std::FILE *file = nullptr;
+    std::thread thread;
+    std::atomic<bool> done{false};
+    bool failed = false;        // Set by the writer thread, read after join
+
+    uint32_t chunkRecords = 1 << 16;
+    uint64_t offset = 0;
+    uint64_t numRecords = 0;
+    std::vector<IndexEntry> index;
+};
+
+#endif
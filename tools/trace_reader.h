@@ -0,0 +1,411 @@
+/**
+ * Memory-Mapped Trace Reader
+ *
+ * Reads binary request traces (tools/trace_format.h) without copying: the
+ * file is mmapped, the chunk index locates every independently decodable
+ * chunk, and worker threads decode chunks straight from the mapping into a
+ * pool of reusable request buffers. The consumer receives the chunks in
+ * trace order through Next(), one block per chunk:
+ *
+ *   TraceReader reader;
+ *   reader.Open("trace.nvmt");
+ *   reader.Start(numThreads);
+ *   TraceBlock block;
+ *   while (reader.Next(block)) {
+ *       for (uint64_t i = 0; i < block.count; i++) use(block.requests[i]);
+ *   }
+ *
+ * A block stays valid until the following call to Next(). Decoding runs at
+ * most Buffers() chunks ahead of the consumer.
+ *
+ * TraceSource wraps TraceReader and falls back to the NVMain text parser
+ * for files that are not binary traces, so tools accept both formats. A
+ * file that starts with the binary magic but does not load is corrupt,
+ * not text.
+ */
+
+#ifndef __TOOLS_TRACE_READER_H__
+#define __TOOLS_TRACE_READER_H__
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace_format.h"
+#include "trace_request.h"
+
+struct TraceBlock {
+    const TraceRequest *requests;
+    uint64_t count;
+    uint64_t firstRecord;   // Position of requests[0] in the trace
+};
+
+class TraceReader {
+public:
+    TraceReader() {}
+
+    ~TraceReader() {
+        Close();
+    }
+
+    /*
+     * Map a binary trace and load its index. Returns false if the file
+     * cannot be mapped or is not a complete binary trace.
+     */
+    bool Open(const std::string& path) {
+        Close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        size = static_cast<uint64_t>(info.st_size);
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            size = 0;
+            return false;
+        }
+        base = static_cast<const uint8_t *>(mapping);
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+        if (!LoadIndex()) {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Close() {
+        Stop();
+        if (base) {
+            ::munmap(const_cast<uint8_t *>(base), size);
+            base = nullptr;
+        }
+        size = 0;
+        indexOffset = 0;
+        index = nullptr;
+        numChunks = 0;
+        numRecords = 0;
+    }
+
+    /*
+     * Start decoding from firstChunk on numThreads worker threads, using
+     * numBuffers request buffers (0 picks two per thread).
+     */
+    void Start(uint64_t numThreads, uint64_t firstChunk = 0, uint64_t numBuffers = 0) {
+        Stop();
+
+        numThreads = std::max<uint64_t>(numThreads, 1);
+        if (numBuffers == 0) {
+            numBuffers = 2 * numThreads;
+        }
+
+        slots.clear();
+        slots.resize(numBuffers);
+        for (uint64_t chunk = firstChunk; chunk < firstChunk + numBuffers; chunk++) {
+            slots[chunk % numBuffers].chunk = chunk;
+        }
+
+        nextChunk = firstChunk;
+        consumeChunk = firstChunk;
+        held = false;
+        stopping = false;
+        error = false;
+
+        for (uint64_t t = 0; t < numThreads; t++) {
+            workers.emplace_back(&TraceReader::Decode, this);
+        }
+    }
+
+    /*
+     * Hand the next chunk to the consumer and release the previous one.
+     * Returns false at the end of the trace or on a corrupt chunk (see
+     * Failed()).
+     */
+    bool Next(TraceBlock& block) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (held) {
+            Slot& previous = slots[(consumeChunk - 1) % slots.size()];
+            previous.ready = false;
+            previous.chunk += slots.size();
+            held = false;
+            decoded.notify_all();
+        }
+
+        if (consumeChunk >= numChunks || workers.empty()) {
+            return false;
+        }
+
+        Slot& slot = slots[consumeChunk % slots.size()];
+        consumed.wait(lock, [&]() { return slot.ready || error; });
+        if (error) {
+            return false;
+        }
+
+        block.requests = slot.requests.data();
+        block.count = index[consumeChunk].numRecords;
+        block.firstRecord = index[consumeChunk].entry.firstRecord;
+        consumeChunk++;
+        held = true;
+        return true;
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        decoded.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    // First chunk holding requests at or after tick, for random seek
+    uint64_t ChunkForTick(uint64_t tick) const {
+        uint64_t low = 0, high = numChunks;
+        while (low < high) {
+            uint64_t mid = (low + high) / 2;
+            if (index[mid].entry.lastTick < tick) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // Chunk holding the given record number
+    uint64_t ChunkForRecord(uint64_t record) const {
+        uint64_t low = 0, high = numChunks;
+        while (high - low > 1) {
+            uint64_t mid = (low + high) / 2;
+            if (index[mid].entry.firstRecord <= record) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    uint64_t NumRecords() const { return numRecords; }
+    uint64_t NumChunks() const { return numChunks; }
+    uint64_t Buffers() const { return slots.size(); }
+    bool HasDataHash() const { return dataHash; }
+    bool HasLineBytes() const { return lineBytes; }
+    bool Failed() const { return error; }
+
+private:
+    struct Chunk {
+        IndexEntry entry;
+        uint64_t numRecords;
+    };
+
+    struct Slot {
+        std::vector<TraceRequest> requests;
+        uint64_t chunk;         // Chunk this buffer decodes next
+        bool ready = false;
+        bool claimed = false;
+    };
+
+    /*
+     * Validate the header, footer and index against the file: every chunk
+     * header lies before the index and the chunks hold increasing record
+     * ranges. Anything else is a corrupt trace.
+     */
+    bool LoadIndex() {
+        FileHeader header;
+        FileFooter footer;
+        if (size < sizeof(header) + sizeof(footer)) {
+            return false;
+        }
+
+        std::memcpy(&header, base, sizeof(header));
+        std::memcpy(&footer, base + size - sizeof(footer), sizeof(footer));
+        if (std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+            || std::memcmp(footer.magic, TRACE_INDEX_MAGIC, sizeof(footer.magic)) != 0
+            || !SupportedHeader(header)) {
+            return false;
+        }
+
+        // Bound the entry count before sizing the index by it
+        const uint64_t indexEnd = size - sizeof(footer);
+        if (footer.numChunks > (indexEnd - sizeof(header)) / sizeof(IndexEntry)
+            || footer.indexOffset != indexEnd - footer.numChunks * sizeof(IndexEntry)) {
+            return false;
+        }
+
+        dataHash = (header.flags & FILE_DATA_HASH) != 0;
+        lineBytes = (header.flags & FILE_LINE_BYTES) != 0;
+        numChunks = footer.numChunks;
+        numRecords = footer.numRecords;
+        indexOffset = footer.indexOffset;
+
+        chunks.resize(numChunks);
+        for (uint64_t c = 0; c < numChunks; c++) {
+            std::memcpy(&chunks[c].entry,
+                        base + indexOffset + c * sizeof(IndexEntry),
+                        sizeof(IndexEntry));
+            const IndexEntry& entry = chunks[c].entry;
+            if (entry.offset < sizeof(header)
+                || entry.offset > indexOffset - sizeof(ChunkHeader)
+                || entry.firstRecord >= numRecords
+                || (c > 0 && entry.firstRecord <= chunks[c - 1].entry.firstRecord)) {
+                return false;
+            }
+        }
+        for (uint64_t c = 0; c < numChunks; c++) {
+            uint64_t end = (c + 1 < numChunks) ? chunks[c + 1].entry.firstRecord
+                                               : numRecords;
+            chunks[c].numRecords = end - chunks[c].entry.firstRecord;
+        }
+        index = chunks.data();
+
+        return true;
+    }
+
+    void Decode() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            // Claim the next chunk once its buffer has been released
+            Slot *slot = nullptr;
+            uint64_t chunk = 0;
+            decoded.wait(lock, [&]() {
+                if (stopping || error || nextChunk >= numChunks) {
+                    return true;
+                }
+                Slot& candidate = slots[nextChunk % slots.size()];
+                return candidate.chunk == nextChunk && !candidate.ready
+                    && !candidate.claimed;
+            });
+            if (stopping || error || nextChunk >= numChunks) {
+                return;
+            }
+
+            chunk = nextChunk++;
+            slot = &slots[chunk % slots.size()];
+            slot->claimed = true;
+            lock.unlock();
+
+            // Decode straight from the mapping, the payload ends before the index
+            ChunkHeader header;
+            const uint8_t *at = base + index[chunk].entry.offset;
+            std::memcpy(&header, at, sizeof(header));
+            bool valid = header.numRecords == index[chunk].numRecords
+                      && header.payloadBytes
+                         <= indexOffset - sizeof(header) - index[chunk].entry.offset;
+            if (valid) {
+                slot->requests.resize(header.numRecords);
+                valid = DecodeChunk(at + sizeof(header), header, dataHash,
+                                    slot->requests.data(), lineBytes);
+            }
+
+            lock.lock();
+            slot->claimed = false;
+            if (valid) {
+                slot->ready = true;
+            } else {
+                error = true;
+            }
+            consumed.notify_all();
+            decoded.notify_all();
+        }
+    }
+
+    const uint8_t *base = nullptr;
+    uint64_t size = 0;
+    uint64_t indexOffset = 0;       // End of the chunk data
+    bool dataHash = false;
+    bool lineBytes = false;
+
+    std::vector<Chunk> chunks;
+    const Chunk *index = nullptr;
+    uint64_t numChunks = 0;
+    uint64_t numRecords = 0;
+
+    std::vector<Slot> slots;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable decoded;    // Buffers released, workers wait
+    std::condition_variable consumed;   // Chunks decoded, consumer waits
+    uint64_t nextChunk = 0;
+    uint64_t consumeChunk = 0;
+    bool held = false;
+    bool stopping = false;
+    bool error = false;
+};
+
+// Reads binary traces with TraceReader, anything else as an NVMain text trace
+class TraceSource {
+public:
+    // False if the file cannot be opened, or is a corrupt binary trace (Failed())
+    bool Open(const std::string& path, uint64_t numThreads) {
+        if (reader.Open(path)) {
+            binary = true;
+            reader.Start(numThreads);
+            return true;
+        }
+
+        binary = false;
+        text.open(path);
+        char magic[sizeof(TRACE_MAGIC)];
+        if (text.read(magic, sizeof(magic))
+            && std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0) {
+            corrupt = true;
+            text.close();
+            return false;
+        }
+        text.clear();
+        text.seekg(0);
+        return text.is_open();
+    }
+
+    bool Next(TraceBlock& block) {
+        if (binary) {
+            return reader.Next(block);
+        }
+
+        block.firstRecord = position;
+        block.count = ReadNVMainTrace(text, 1 << 16, buffer);
+        block.requests = buffer.data();
+        position += block.count;
+        return block.count > 0;
+    }
+
+    bool IsBinary() const { return binary; }
+    bool Failed() const { return corrupt || (binary && reader.Failed()); }
+
+private:
+    TraceReader reader;
+    std::ifstream text;
+    std::vector<TraceRequest> buffer;
+    uint64_t position = 0;
+    bool binary = false;
+    bool corrupt = false;
+};
+
+#endif
@@ -0,0 +1,724 @@
+/**
+ * Trace Replay for Dynamic ReRAM Region Mapping
+ *
+ * Replays a recorded request trace through the bank/channel timing model of
+ * tools/replay_engine.h: region translation and migrations per bank,
+ * controller queue, bank and data bus contention per channel. Banks and
+ * channels are replayed on separate threads; --serial runs the reference
+ * one-request-at-a-time replay instead, and --verify runs both and checks
+ * that every statistic is identical.
+ *
+ * Timing parameters come from the NVMain configuration: FastRegionLatency,
+ * SlowRegionLatency, EpochLength, Alpha, Beta, MigrationThreshold,
+ * QueueSize and tBURST. MappingCacheEntries > 0 keeps the region table in
+ * the NVM behind a mapping cache of that many entries (MappingCacheAssoc
+ * ways, MappingEntriesPerLine entries per metadata line, misses cost
+ * MetadataReadLatency and write-backs MetadataWriteLatency cycles).
+ * MigrationScheme swap|rotate picks pairwise swaps or free-region rotation;
+ * --swap-cost only applies to swaps, rotation costs are per region copy.
+ * Migrated rows cross the channel bus twice (MigrationRowBusCycles each
+ * way, default one tBURST per 64 bytes of row) unless InBankCopy true
+ * copies them inside the bank (RowCloneLatency within a mat,
+ * RowCloneBankLatency between mats). RowMoveEnergy and RowCloneEnergy
+ * (pJ per row) give the migration energy of either path.
+ * Migrations of different banks run concurrently; MigrationTokenCycles
+ * (cycles per moved row, 0 = unlimited) and MigrationTokenBurst (rows,
+ * default one migration) cap their aggregate bandwidth. Swap lists are
+ * applied DecisionLatency cycles after each epoch boundary and computed
+ * on helper threads meanwhile. MatGroups independent mat groups per bank
+ * overlap operations on different mats (1 = bank-serial) and
+ * MatAwarePlacement true spreads hot regions across them. PagePolicy
+ * closed|open|adaptive picks the row buffer policy with
+ * Fast/SlowRowHitLatency and Fast/SlowRowConflictLatency, and
+ * RowHitDiscount lowers the migration score of row buffer hits.
+ * MLCWrites true adds multi-level cell program-and-verify time to writes:
+ * MLCIterationCycles per pulse, MLCSlowScale percent pulses in slow
+ * regions and MLCLevel0..3Iterations, 16 comma-separated pulse counts per
+ * cell level. ScrubInterval > 0 scrubs every row once per interval (fast
+ * regions every ScrubFastPasses intervals) at Fast/SlowScrubLatency per
+ * row, in idle bank time until ScrubDeadline cycles after release.
+ * EnduranceWrites > 0 wears rows out after that many writes (varied by
+ * EnduranceVariation percent, each write aging AgingFactor times) and
+ * retires regions with RetireFailedRows failed rows into SpareRegions
+ * spare regions per bank. EccRegions off|slow|all adds ECC encode
+ * (EccEncodeLatency), decode (EccDecodeLatency) and correction
+ * (EccCorrectLatency, EccErrorPpm plus EccWearPpm per 1000 region writes)
+ * latency and error correction pointer writes (EccPointerLatency).
+ * Compression true stores lines BDI/FPC compressed when the trace has
+ * their compressed size (text traces with data, trace_convert
+ * --line-bytes): writes program fewer MLC cells and reads of compressed
+ * lines add DecompressLatency.
+ * TenantQuotas, comma-separated fast regions per bank for tenants 0, 1, ...
+ * (requestor IDs, the last tenant takes the higher IDs), keeps each tenant
+ * within its quota of fast regions; TenantBorrowing true lets a tenant
+ * use fast regions beyond its quota until another tenant needs them.
+ * --monitor ms reads the published mapping
+ * snapshots from a separate thread while the replay runs and prints the
+ * number of migrated regions.
+ *
+ * Usage:
+ *   trace_replay --config <nvmain.config> --trace <trace.nvt|trace.nvmt>
+ *                [--threads N] [--policy threshold|linear]
+ *                [--swap-cost cycles] [--serial] [--verify]
+ *                [--order R:RK:BK:CH:C] [--monitor ms]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "migration_policy.h"
+#include "region_geometry.h"
+#include "replay_engine.h"
+#include "trace_reader.h"
+
+static void PrintUsage() {
+    std::cout << "Usage: trace_replay --config <nvmain.config> "
+              << "--trace <trace.nvt|trace.nvmt>" << std::endl
+              << "                    [--threads N] "
+              << "[--policy threshold|linear]" << std::endl
+              << "                    [--swap-cost cycles] [--serial] [--verify]"
+              << std::endl
+              << "                    [--order R:RK:BK:CH:C] [--monitor ms]"
+              << std::endl;
+}
+
+/*
+ * Print the published mapping of every bank each intervalMs until done.
+ * Runs next to the replay and never blocks it.
+ */
+template <typename Replay>
+static void MonitorMapping(Replay& replay, uint64_t numBanks, uint64_t intervalMs,
+                           const std::atomic<bool>& done) {
+    SnapshotReader reader(replay.Snapshots());
+    if (!reader.Registered()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (!done.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+
+        uint64_t versions = 0, migrated = 0, epochs = 0;
+        {
+            SnapshotReader::Section section(reader);
+            for (uint64_t bank = 0; bank < numBanks; bank++) {
+                const MappingSnapshot *snapshot = replay.Mapping(bank).Read();
+                versions += snapshot->version;
+                epochs = std::max(epochs, snapshot->epoch);
+                for (uint64_t VRN = 0; VRN < snapshot->PRN.size(); VRN++) {
+                    migrated += snapshot->PRN[VRN] != VRN;
+                }
+            }
+        }
+
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        std::printf("[monitor] %.2fs: epoch %llu, %llu table versions, "
+                    "%llu migrated regions\n", seconds,
+                    static_cast<unsigned long long>(epochs),
+                    static_cast<unsigned long long>(versions),
+                    static_cast<unsigned long long>(migrated));
+    }
+}
+
+template <typename Replay>
+static void ReplayTrace(Replay& replay, TraceSource& trace, uint64_t numBanks,
+                        uint64_t monitorMs) {
+    std::atomic<bool> done(false);
+    std::thread monitor;
+    if (monitorMs > 0) {
+        monitor = std::thread([&]() {
+            MonitorMapping(replay, numBanks, monitorMs, done);
+        });
+    }
+
+    TraceBlock block;
+    while (trace.Next(block)) {
+        replay.Replay(block.requests, block.count);
+    }
+
+    done.store(true);
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+}
+
+/*
+ * Replay the whole trace with the parallel engine (numThreads > 0) or the
+ * serial reference (numThreads == 0). Returns false if the trace cannot
+ * be read.
+ */
+static bool RunReplay(const std::string& traceFile, const RegionGeometry& geometry,
+                      const ReplayParams& params, uint64_t numThreads,
+                      uint64_t monitorMs, ReplayStats& stats, double& seconds) {
+    TraceSource trace;
+    if (!trace.Open(traceFile, std::max<uint64_t>(numThreads, 1))) {
+        std::cerr << "Error: " << (trace.Failed() ? "corrupt" : "cannot open")
+                  << " trace " << traceFile << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (numThreads > 0) {
+        ReplayEngine engine(geometry, params, numThreads);
+        ReplayTrace(engine, trace, geometry.NumBanks(), monitorMs);
+        stats = engine.Stats();
+    } else {
+        ReplaySerial serial(geometry, params);
+        ReplayTrace(serial, trace, geometry.NumBanks(), monitorMs);
+        stats = serial.Stats();
+    }
+
+    seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (trace.Failed()) {
+        std::cerr << "Error: corrupt trace " << traceFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Parse MLCLevel<level>Iterations, 16 comma-separated pulse counts
+static bool ParseIterations(const NVMainConfig& config, uint64_t level,
+                            MLCParams& mlc) {
+    const std::string key = "MLCLevel" + std::to_string(level) + "Iterations";
+    const std::string value = ConfigString(config, key, "");
+    if (value.empty()) {
+        return true;
+    }
+
+    uint64_t entry = 0;
+    size_t begin = 0;
+    while (begin <= value.size()) {
+        size_t end = std::min(value.find(',', begin), value.size());
+        unsigned long count = std::strtoul(value.c_str() + begin, nullptr, 10);
+        if (entry == MLCParams::ENTRIES || count == 0 || count > 255) {
+            return false;
+        }
+        mlc.iterations[level][entry++] = static_cast<uint8_t>(count);
+        begin = end + 1;
+    }
+    return entry == MLCParams::ENTRIES;
+}
+
+// Parse TenantQuotas, comma-separated fast regions per bank
+static bool ParseQuotas(const NVMainConfig& config, uint64_t fastRegions,
+                        std::vector<uint64_t>& quotas) {
+    const std::string value = ConfigString(config, "TenantQuotas", "");
+    quotas.clear();
+    size_t begin = 0;
+    while (!value.empty() && begin <= value.size()) {
+        size_t end = std::min(value.find(',', begin), value.size());
+        char *last;
+        unsigned long long quota = std::strtoull(value.c_str() + begin, &last, 10);
+        if (last == value.c_str() + begin || quota > fastRegions) {
+            return false;
+        }
+        quotas.push_back(quota);
+        begin = end + 1;
+    }
+    return quotas.size() <= 64;
+}
+
+static void PrintStats(const char *name, const ReplayStats& stats, double seconds,
+                       uint64_t numGroups) {
+    double requests = std::max<uint64_t>(stats.requests, 1);
+
+    std::printf("%-10s %12s %10s %10s %12s %10s %10s %10s %10s\n", "Replay",
+                "Requests", "Fast %", "Swaps", "Avg latency", "Queue",
+                "Bank", "Bus", "Seconds");
+    std::printf("%-10s %12llu %9.2f%% %10llu %12.2f %10.2f %10.2f %10.2f %10.3f\n",
+                name, static_cast<unsigned long long>(stats.requests),
+                100.0 * stats.fastAccesses / requests,
+                static_cast<unsigned long long>(stats.migrations),
+                stats.totalLatency / requests, stats.queueCycles / requests,
+                stats.bankCycles / requests, stats.busCycles / requests, seconds);
+
+    std::printf("%-10s rows moved %llu, migration cycles %llu (%.2f per row)\n", "",
+                static_cast<unsigned long long>(stats.rowsMoved),
+                static_cast<unsigned long long>(stats.migrationCycles),
+                stats.rowsMoved ? static_cast<double>(stats.migrationCycles)
+                                  / stats.rowsMoved : 0.0);
+    std::printf("%-10s migration bus cycles %llu, rows cloned in bank %llu, "
+                "energy %.3f uJ, token wait %.2f cycles per migration\n", "",
+                static_cast<unsigned long long>(stats.migrationBusCycles),
+                static_cast<unsigned long long>(stats.rowsCloned),
+                stats.migrationEnergy / 1e6,
+                stats.migrations ? static_cast<double>(stats.migrationDelay)
+                                   / stats.migrations : 0.0);
+
+    double elapsed = std::max<uint64_t>(stats.lastCompletion, 1);
+    std::printf("%-10s mat group utilization %.2f%% average, %.2f%% busiest, "
+                "overlap %.3f\n", "",
+                100.0 * stats.matBusyCycles / (elapsed * numGroups),
+                100.0 * stats.matBusyMax / elapsed,
+                stats.bankActiveCycles ? static_cast<double>(stats.matBusyCycles)
+                                         / stats.bankActiveCycles : 0.0);
+
+    uint64_t fastRow = stats.fastRowHits + stats.fastRowMisses + stats.fastRowConflicts;
+    uint64_t slowRow = stats.slowRowHits + stats.slowRowMisses + stats.slowRowConflicts;
+    std::printf("%-10s row hit/miss/conflict: fast %.2f/%.2f/%.2f%%, "
+                "slow %.2f/%.2f/%.2f%%\n", "",
+                100.0 * stats.fastRowHits / std::max<uint64_t>(fastRow, 1),
+                100.0 * stats.fastRowMisses / std::max<uint64_t>(fastRow, 1),
+                100.0 * stats.fastRowConflicts / std::max<uint64_t>(fastRow, 1),
+                100.0 * stats.slowRowHits / std::max<uint64_t>(slowRow, 1),
+                100.0 * stats.slowRowMisses / std::max<uint64_t>(slowRow, 1),
+                100.0 * stats.slowRowConflicts / std::max<uint64_t>(slowRow, 1));
+
+    if (stats.failedRows > 0) {
+        std::printf("%-10s wear-out: %llu failed rows, %llu regions retired, "
+                    "%llu unrepaired, %llu rotation spares lost, "
+                    "%llu accesses to failed rows\n", "",
+                    static_cast<unsigned long long>(stats.failedRows),
+                    static_cast<unsigned long long>(stats.regionsRetired),
+                    static_cast<unsigned long long>(stats.regionsUnrepaired),
+                    static_cast<unsigned long long>(stats.sparesLost),
+                    static_cast<unsigned long long>(stats.faultyAccesses));
+    }
+
+    if (stats.eccEncodes + stats.eccDecodes > 0) {
+        std::printf("%-10s ECC: %llu encodes, %llu decodes, %llu corrections, "
+                    "%llu pointer updates, %.2f cycles per request\n", "",
+                    static_cast<unsigned long long>(stats.eccEncodes),
+                    static_cast<unsigned long long>(stats.eccDecodes),
+                    static_cast<unsigned long long>(stats.eccCorrections),
+                    static_cast<unsigned long long>(stats.eccPointerUpdates),
+                    stats.eccCycles / requests);
+    }
+
+    if (stats.scrubRows > 0) {
+        std::printf("%-10s scrub rows %llu, %.2f%% of mat group time, %llu escalated, "
+                    "%.2f cycles demand delay per request\n", "",
+                    static_cast<unsigned long long>(stats.scrubRows),
+                    100.0 * stats.scrubCycles / (elapsed * numGroups),
+                    static_cast<unsigned long long>(stats.scrubEscalations),
+                    stats.scrubDelay / requests);
+    }
+
+    if (stats.lineBytesUncompressed > 0) {
+        std::printf("%-10s compression: ratio %.2f, %.2f%% of writes compressed, "
+                    "%llu cells written, %llu program cycles saved, "
+                    "%llu decompression cycles\n", "",
+                    static_cast<double>(stats.lineBytesUncompressed)
+                    / std::max<uint64_t>(stats.lineBytesWritten, 1),
+                    100.0 * stats.compressedWrites
+                    / std::max<uint64_t>(stats.writes, 1),
+                    static_cast<unsigned long long>(stats.cellsWritten),
+                    static_cast<unsigned long long>(stats.compressionSavedCycles),
+                    static_cast<unsigned long long>(stats.decompressCycles));
+    }
+
+    if (stats.mlcIterations > 0) {
+        double writes = std::max<uint64_t>(stats.writes, 1);
+        std::printf("%-10s MLC program-and-verify: %.2f pulses, %.2f cycles per write\n",
+                    "", stats.mlcIterations / writes, stats.mlcProgramCycles / writes);
+    }
+
+    for (uint64_t i = 0; i < stats.tenants.size(); i++) {
+        const TenantStats& tenant = stats.tenants[i];
+        std::printf("%-10s tenant %llu: %llu requests, %.2f%% fast, %.2f avg latency, "
+                    "%.2f fast regions per bank\n", "",
+                    static_cast<unsigned long long>(i),
+                    static_cast<unsigned long long>(tenant.requests),
+                    100.0 * tenant.fastAccesses / std::max<uint64_t>(tenant.requests, 1),
+                    static_cast<double>(tenant.totalLatency)
+                    / std::max<uint64_t>(tenant.requests, 1),
+                    static_cast<double>(tenant.fastRegions)
+                    / std::max<uint64_t>(stats.tenantDecisions, 1));
+    }
+    if (!stats.tenants.empty()) {
+        std::printf("%-10s quotas: %llu swaps denied, %llu regions borrowed, "
+                    "%llu reclaimed\n", "",
+                    static_cast<unsigned long long>(stats.quotaDenials),
+                    static_cast<unsigned long long>(stats.quotaBorrows),
+                    static_cast<unsigned long long>(stats.quotaReclaims));
+    }
+
+    uint64_t lookups = stats.mappingHits + stats.mappingMisses;
+    if (lookups > 0) {
+        std::printf("%-10s mapping cache hit rate %.2f%%, metadata reads %llu, "
+                    "metadata writes %llu\n", "",
+                    100.0 * stats.mappingHits / lookups,
+                    static_cast<unsigned long long>(stats.metadataReads),
+                    static_cast<unsigned long long>(stats.metadataWrites));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string configFile, traceFile;
+    uint64_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    RegionGeometry geometry;
+    ReplayParams params;
+    uint64_t monitorMs = 0;
+    bool serial = false, verify = false, swapCostSet = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--serial") {
+            serial = true;
+            continue;
+        }
+        if (arg == "--verify") {
+            verify = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            PrintUsage();
+            return 1;
+        }
+
+        if (arg == "--config") {
+            configFile = argv[++i];
+        } else if (arg == "--trace") {
+            traceFile = argv[++i];
+        } else if (arg == "--threads") {
+            numThreads = std::max(1ULL, std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--policy") {
+            params.policy = argv[++i];
+        } else if (arg == "--swap-cost") {
+            params.swapCost = std::strtoull(argv[++i], nullptr, 10);
+            swapCostSet = true;
+        } else if (arg == "--order") {
+            geometry.order = argv[++i];
+        } else if (arg == "--monitor") {
+            monitorMs = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (configFile.empty() || traceFile.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    NVMainConfig config;
+    if (!ReadNVMainConfig(configFile, config)) {
+        std::cerr << "Error: cannot read configuration " << configFile << std::endl;
+        return 1;
+    }
+
+    geometry.Configure(config);
+    if (!geometry.Initialize()) {
+        return 1;
+    }
+
+    params.epochLength = ConfigValue(config, "EpochLength", params.epochLength);
+    params.fastLatency = ConfigValue(config, "FastRegionLatency", params.fastLatency);
+    params.slowLatency = ConfigValue(config, "SlowRegionLatency", params.slowLatency);
+    params.queueSize = ConfigValue(config, "QueueSize", params.queueSize);
+    params.burstCycles = ConfigValue(config, "tBURST", params.burstCycles);
+    params.mappingCacheEntries =
+        ConfigValue(config, "MappingCacheEntries", params.mappingCacheEntries);
+    params.mappingCacheAssoc =
+        ConfigValue(config, "MappingCacheAssoc", params.mappingCacheAssoc);
+    params.mappingEntriesPerLine =
+        ConfigValue(config, "MappingEntriesPerLine", params.mappingEntriesPerLine);
+    params.migrationScheme =
+        ConfigString(config, "MigrationScheme", params.migrationScheme);
+    params.inBankCopy = ConfigString(config, "InBankCopy", "false") == "true";
+    params.rowCloneLatency =
+        ConfigValue(config, "RowCloneLatency", params.slowLatency);
+    params.rowCloneBankLatency =
+        ConfigValue(config, "RowCloneBankLatency",
+                    params.fastLatency + params.slowLatency);
+    params.migrationRowBusCycles =
+        ConfigValue(config, "MigrationRowBusCycles",
+                    geometry.cols * geometry.busWidth / 8 / 64 * params.burstCycles);
+    params.decisionLatency = ConfigValue(config, "DecisionLatency", params.decisionLatency);
+    params.matGroups = ConfigValue(config, "MatGroups", params.matGroups);
+    params.matAwarePlacement = ConfigString(config, "MatAwarePlacement", "false") == "true";
+    params.pagePolicy = ConfigString(config, "PagePolicy", params.pagePolicy);
+    params.fastRowHitLatency =
+        ConfigValue(config, "FastRowHitLatency", params.fastRowHitLatency);
+    params.slowRowHitLatency =
+        ConfigValue(config, "SlowRowHitLatency", params.slowRowHitLatency);
+    params.fastRowConflictLatency =
+        ConfigValue(config, "FastRowConflictLatency", params.fastLatency + 20);
+    params.slowRowConflictLatency =
+        ConfigValue(config, "SlowRowConflictLatency", params.slowLatency + 20);
+    params.scrubInterval = ConfigValue(config, "ScrubInterval", params.scrubInterval);
+    params.scrubDeadline = ConfigValue(config, "ScrubDeadline", params.scrubInterval);
+    params.scrubFastPasses = ConfigValue(config, "ScrubFastPasses", params.scrubFastPasses);
+    params.fastScrubLatency = ConfigValue(config, "FastScrubLatency", params.fastLatency);
+    params.slowScrubLatency = ConfigValue(config, "SlowScrubLatency", params.slowLatency);
+    params.enduranceWrites = ConfigValue(config, "EnduranceWrites", params.enduranceWrites);
+    params.enduranceVariation =
+        ConfigValue(config, "EnduranceVariation", params.enduranceVariation);
+    params.agingFactor = ConfigValue(config, "AgingFactor", params.agingFactor);
+    params.spareRegions = ConfigValue(config, "SpareRegions", params.spareRegions);
+    params.retireFailedRows =
+        ConfigValue(config, "RetireFailedRows", params.retireFailedRows);
+    params.eccRegions = ConfigString(config, "EccRegions", params.eccRegions);
+    params.eccEncodeLatency = ConfigValue(config, "EccEncodeLatency", params.eccEncodeLatency);
+    params.eccDecodeLatency = ConfigValue(config, "EccDecodeLatency", params.eccDecodeLatency);
+    params.eccCorrectLatency =
+        ConfigValue(config, "EccCorrectLatency", params.eccCorrectLatency);
+    params.eccPointerLatency = ConfigValue(config, "EccPointerLatency", params.slowLatency);
+    params.eccErrorPpm = ConfigValue(config, "EccErrorPpm", params.eccErrorPpm);
+    params.eccWearPpm = ConfigValue(config, "EccWearPpm", params.eccWearPpm);
+    params.compression = ConfigString(config, "Compression", "false") == "true";
+    params.decompressLatency =
+        ConfigValue(config, "DecompressLatency", params.decompressLatency);
+    params.mlcWrites = ConfigString(config, "MLCWrites", "false") == "true";
+    params.mlc.iterationCycles =
+        ConfigValue(config, "MLCIterationCycles", params.mlc.iterationCycles);
+    params.mlc.slowScale = ConfigValue(config, "MLCSlowScale", params.mlc.slowScale);
+    for (uint64_t level = 0; level < MLCParams::LEVELS; level++) {
+        if (!ParseIterations(config, level, params.mlc)) {
+            std::cerr << "Error: MLCLevel" << level << "Iterations must be "
+                      << MLCParams::ENTRIES << " comma-separated counts from 1 to 255"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (!ParseQuotas(config, geometry.FastRegionsPerBank(), params.tenantQuotas)) {
+        std::cerr << "Error: TenantQuotas must be at most 64 comma-separated counts "
+                  << "of at most " << geometry.FastRegionsPerBank() << " fast regions"
+                  << std::endl;
+        return 1;
+    }
+    params.tenantBorrowing = ConfigString(config, "TenantBorrowing", "false") == "true";
+    params.migrationTokenCycles =
+        ConfigValue(config, "MigrationTokenCycles", params.migrationTokenCycles);
+    params.migrationTokenBurst =
+        ConfigValue(config, "MigrationTokenBurst", 2 * geometry.regionSize);
+    params.rowMoveEnergy = ConfigValue(config, "RowMoveEnergy", params.rowMoveEnergy);
+    params.rowCloneEnergy = ConfigValue(config, "RowCloneEnergy", params.rowCloneEnergy);
+    params.metadataReadLatency =
+        ConfigValue(config, "MetadataReadLatency", params.fastLatency);
+    params.metadataWriteLatency =
+        ConfigValue(config, "MetadataWriteLatency", params.slowLatency);
+    params.policyParams.alpha = ConfigDouble(config, "Alpha", params.policyParams.alpha);
+    params.policyParams.beta = ConfigDouble(config, "Beta", params.policyParams.beta);
+    params.policyParams.migrationThreshold =
+        ConfigDouble(config, "MigrationThreshold",
+                     params.policyParams.migrationThreshold);
+    params.policyParams.rowHitDiscount =
+        ConfigDouble(config, "RowHitDiscount", params.policyParams.rowHitDiscount);
+    params.policyParams.readSaving =
+        static_cast<double>(params.slowLatency - params.fastLatency);
+    params.policyParams.writeSaving = params.policyParams.readSaving;
+
+    // With ECC on slow regions only, a fast placement also saves the
+    // coding latency (expected correction at the base error rate)
+    if (params.eccRegions == "slow") {
+        params.policyParams.readSaving +=
+            params.eccDecodeLatency
+            + params.eccCorrectLatency * (params.eccErrorPpm / 1e6);
+        params.policyParams.writeSaving += params.eccEncodeLatency;
+    }
+
+    // Default swap cost: both regions are read and written row by row
+    if (!swapCostSet) {
+        params.swapCost = 2 * geometry.regionSize
+                        * (params.fastLatency + params.slowLatency);
+    }
+    params.policyParams.swapCost = static_cast<double>(params.swapCost);
+
+    if (params.epochLength == 0 || params.queueSize == 0
+        || params.mappingEntriesPerLine == 0
+        || params.slowLatency < params.fastLatency) {
+        std::cerr << "Error: EpochLength, QueueSize and MappingEntriesPerLine "
+                  << "must be positive and SlowRegionLatency at least "
+                  << "FastRegionLatency" << std::endl;
+        return 1;
+    }
+
+    const uint64_t matsPerBank = geometry.rows / geometry.matHeight;
+    if (params.matGroups == 0 || params.matGroups > std::min<uint64_t>(matsPerBank, 64)) {
+        std::cerr << "Error: MatGroups must be between 1 and the number of mats "
+                  << "per bank (at most 64)" << std::endl;
+        return 1;
+    }
+
+    if (params.pagePolicy != "closed" && params.pagePolicy != "open"
+        && params.pagePolicy != "adaptive") {
+        std::cerr << "Error: PagePolicy must be closed, open or adaptive" << std::endl;
+        return 1;
+    }
+
+    if (params.scrubFastPasses == 0) {
+        std::cerr << "Error: ScrubFastPasses must be positive" << std::endl;
+        return 1;
+    }
+
+    // Scrub time per row must fit in the row's share of the interval
+    const uint64_t scrubRows = geometry.RegionsPerBank() * geometry.regionSize;
+    if (params.scrubInterval > 0
+        && params.scrubInterval / scrubRows <= params.slowScrubLatency) {
+        std::cerr << "Error: ScrubInterval must exceed SlowScrubLatency per row ("
+                  << scrubRows * params.slowScrubLatency << " cycles)" << std::endl;
+        return 1;
+    }
+
+    if (params.enduranceVariation >= 100 || params.agingFactor == 0
+        || params.retireFailedRows == 0
+        || params.retireFailedRows > geometry.regionSize) {
+        std::cerr << "Error: EnduranceVariation must be below 100, AgingFactor "
+                  << "positive and RetireFailedRows between 1 and RegionSize"
+                  << std::endl;
+        return 1;
+    }
+
+    if (params.eccRegions != "off" && params.eccRegions != "slow"
+        && params.eccRegions != "all") {
+        std::cerr << "Error: EccRegions must be off, slow or all" << std::endl;
+        return 1;
+    }
+
+    if (params.decisionLatency >= params.epochLength) {
+        std::cerr << "Error: DecisionLatency must be less than EpochLength" << std::endl;
+        return 1;
+    }
+
+    if (params.migrationScheme != "swap" && params.migrationScheme != "rotate") {
+        std::cerr << "Error: MigrationScheme must be swap or rotate" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<MigrationPolicy> check(
+        CreateMigrationPolicy(params.policy, params.policyParams));
+    if (!check) {
+        std::cerr << "Error: unknown policy " << params.policy
+                  << " or invalid policy parameters" << std::endl;
+        return 1;
+    }
+
+    std::cout << "========================================" << std::endl;
+    std::cout << "ReRAM Trace Replay" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "Trace: " << traceFile << std::endl;
+    std::cout << "Banks: " << geometry.NumBanks() << ", regions per bank: "
+              << geometry.RegionsPerBank() << " ("
+              << geometry.FastRegionsPerBank() << " fast)" << std::endl;
+    std::cout << "Latency: fast " << params.fastLatency << ", slow "
+              << params.slowLatency << ", burst " << params.burstCycles
+              << " cycles" << std::endl;
+    std::cout << "Queue size: " << params.queueSize << std::endl;
+    if (params.migrationScheme == "rotate") {
+        std::cout << "Migration: rotate through one spare region per bank, "
+                  << "1 row buffer" << std::endl;
+    } else {
+        std::cout << "Migration: swap, " << params.swapCost << " cycles, "
+                  << geometry.regionSize << " row buffer" << std::endl;
+    }
+    if (params.inBankCopy) {
+        std::cout << "Migration copies: in bank, " << params.rowCloneLatency
+                  << " cycles per row (same mat), " << params.rowCloneBankLatency
+                  << " (other mat)" << std::endl;
+    } else {
+        std::cout << "Migration copies: through the controller, "
+                  << params.migrationRowBusCycles << " bus cycles per row each way"
+                  << std::endl;
+    }
+    std::cout << "Mat groups: " << params.matGroups << " of " << matsPerBank
+              << " mats per bank"
+              << (params.matAwarePlacement ? ", mat-aware placement" : "") << std::endl;
+    std::cout << "Page policy: " << params.pagePolicy;
+    if (params.pagePolicy != "closed") {
+        std::cout << ", row hit " << params.fastRowHitLatency << "/"
+                  << params.slowRowHitLatency << ", conflict "
+                  << params.fastRowConflictLatency << "/"
+                  << params.slowRowConflictLatency << " cycles (fast/slow)";
+    }
+    std::cout << std::endl;
+    if (params.enduranceWrites > 0) {
+        std::cout << "Endurance: " << params.enduranceWrites << " writes per row (+/- "
+                  << params.enduranceVariation << "%), aging x" << params.agingFactor
+                  << ", " << params.spareRegions << " spare regions per bank" << std::endl;
+    }
+    if (params.eccRegions != "off") {
+        std::cout << "ECC: " << params.eccRegions << " regions, encode "
+                  << params.eccEncodeLatency << ", decode " << params.eccDecodeLatency
+                  << ", correct " << params.eccCorrectLatency << " cycles, "
+                  << params.eccErrorPpm << " ppm + " << params.eccWearPpm
+                  << " ppm per 1000 writes" << std::endl;
+    }
+    if (params.scrubInterval > 0) {
+        std::cout << "Scrubbing: every " << params.scrubInterval << " cycles (fast "
+                  << "regions every " << params.scrubFastPasses << "), "
+                  << params.fastScrubLatency << "/" << params.slowScrubLatency
+                  << " cycles per row, deadline " << params.scrubDeadline << std::endl;
+    }
+    if (params.compression) {
+        std::cout << "Compression: BDI/FPC, decompression " << params.decompressLatency
+                  << " cycles" << std::endl;
+    }
+    if (params.mlcWrites) {
+        std::cout << "MLC writes: " << params.mlc.iterationCycles
+                  << " cycles per pulse, slow regions " << params.mlc.slowScale
+                  << "% pulses" << std::endl;
+    }
+    if (!params.tenantQuotas.empty()) {
+        std::cout << "Tenant quotas:";
+        for (uint64_t quota : params.tenantQuotas) {
+            std::cout << " " << quota;
+        }
+        std::cout << " fast regions per bank"
+                  << (params.tenantBorrowing ? ", borrowing" : "") << std::endl;
+    }
+    std::cout << "Decision latency: " << params.decisionLatency << " cycles"
+              << std::endl;
+    if (params.migrationTokenCycles > 0) {
+        std::cout << "Migration budget: one row per " << params.migrationTokenCycles
+                  << " cycles, burst " << params.migrationTokenBurst << " rows"
+                  << std::endl;
+    } else {
+        std::cout << "Migration budget: unlimited" << std::endl;
+    }
+    if (params.mappingCacheEntries > 0) {
+        std::cout << "Mapping cache: " << params.mappingCacheEntries
+                  << " entries, " << params.mappingCacheAssoc << "-way, "
+                  << params.mappingEntriesPerLine << " entries per line"
+                  << std::endl;
+    } else {
+        std::cout << "Mapping cache: off (region table in SRAM)" << std::endl;
+    }
+    std::cout << "Threads: " << (serial ? 1 : numThreads) << std::endl << std::endl;
+
+    ReplayStats stats, reference;
+    double seconds, referenceSeconds;
+
+    if (!serial && !RunReplay(traceFile, geometry, params, numThreads, monitorMs,
+                              stats, seconds)) {
+        return 1;
+    }
+    if ((serial || verify)
+        && !RunReplay(traceFile, geometry, params, 0, monitorMs, reference,
+                      referenceSeconds)) {
+        return 1;
+    }
+
+    if (!serial) {
+        PrintStats("parallel", stats, seconds, geometry.NumBanks() * params.matGroups);
+    }
+    if (serial || verify) {
+        PrintStats("serial", reference, referenceSeconds,
+                   geometry.NumBanks() * params.matGroups);
+    }
+
+    if (verify) {
+        std::cout << std::endl;
+        if (!(stats == reference)) {
+            std::cout << "✗ Parallel replay differs from serial replay" << std::endl;
+            return 1;
+        }
+        std::cout << "✓ Parallel replay identical to serial replay" << std::endl;
+    }
+
+    return 0;
+}
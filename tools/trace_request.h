@@ -0,0 +1,110 @@
+/**
+ * Memory Request Traces
+ *
+ * A TraceRequest is one request that reached NVMain. The text trace written
+ * by NVMain's trace writer (printtrace) has one request per line:
+ *   <cycle> <R|W> <address> <data> [<old data>] <thread id>
+ * preceded by an "NVMV<version>" header line.
+ */
+
+#ifndef __TOOLS_TRACE_REQUEST_H__
+#define __TOOLS_TRACE_REQUEST_H__
+
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "line_compression.h"
+
+enum TraceOp : uint8_t {
+    TRACE_READ = 0,
+    TRACE_WRITE = 1
+};
+
+struct TraceRequest {
+    uint64_t cycle;
+    uint64_t address;
+    uint64_t dataHash;   // 0 if the data was not recorded
+    uint32_t size;
+    uint16_t requestor;
+    uint8_t op;
+    uint8_t lineBytes;   // Compressed size of the line, 0 if unknown
+};
+
+// FNV-1a hash of the data field, so equal data gives equal hashes
+inline uint64_t HashTraceData(const std::string& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : data) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Parse one line of an NVMain text trace. Returns false for the header,
+ * empty lines and lines that are not reads or writes.
+ */
+inline bool ParseNVMainTraceLine(const std::string& line, TraceRequest& request) {
+    std::istringstream fields(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (fields >> token) {
+        tokens.push_back(token);
+    }
+
+    if (tokens.size() < 3 || tokens[0].compare(0, 4, "NVMV") == 0) {
+        return false;
+    }
+
+    if (tokens[1] == "R") {
+        request.op = TRACE_READ;
+    } else if (tokens[1] == "W") {
+        request.op = TRACE_WRITE;
+    } else {
+        return false;
+    }
+
+    request.cycle = std::strtoull(tokens[0].c_str(), nullptr, 10);
+    request.address = std::strtoull(tokens[2].c_str(), nullptr, 16);
+    request.dataHash = 0;
+    request.size = 64;
+    request.requestor = 0;
+    request.lineBytes = 0;
+
+    if (tokens.size() >= 4) {
+        request.dataHash = HashTraceData(tokens[3]);
+        request.lineBytes = static_cast<uint8_t>(CompressedLineSize(tokens[3]));
+    }
+
+    if (tokens.size() >= 5) {
+        request.requestor = static_cast<uint16_t>(
+            std::strtoul(tokens.back().c_str(), nullptr, 10));
+    }
+
+    return true;
+}
+
+/*
+ * Read up to maxRequests requests from an NVMain text trace into requests.
+ * Returns the number of requests read, 0 at the end of the trace.
+ */
+inline uint64_t ReadNVMainTrace(std::istream& trace, uint64_t maxRequests,
+                                std::vector<TraceRequest>& requests) {
+    requests.clear();
+
+    std::string line;
+    TraceRequest request;
+    while (requests.size() < maxRequests && std::getline(trace, line)) {
+        if (ParseNVMainTraceLine(line, request)) {
+            requests.push_back(request);
+        }
+    }
+
+    return requests.size();
+}
+
+#endif